@@ -0,0 +1,349 @@
+//========================================================//
+//  bench.cpp                                             //
+//  Microbenchmarks for the Branch Predictor kernels      //
+//                                                        //
+//  Times the predictor, counter and trace reader kernels //
+//  in ns per branch on synthetic and real trace input    //
+//========================================================//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "predictor.h"
+#include "trace.h"
+
+//------------------------------------//
+//        Benchmark Configuration     //
+//------------------------------------//
+int benchReps = 10;           // timed repetitions after one warmup run
+int benchRecords = 1 << 20;   // conditional branches per run
+int benchStaticBranches = 4096; // distinct pcs in the synthetic input
+
+//------------------------------------//
+//       Benchmark Data Structures    //
+//------------------------------------//
+
+// One benchmark input: the conditional branches of a trace plus its
+// text, so the reader can be timed without touching the disk
+struct bench_input
+{
+  const char *name;
+  uint32_t *pc;
+  uint32_t *outcome;
+  int count;
+  char *text;
+  size_t textLength;
+  int records; //records in text, conditional or not
+};
+
+typedef void (*bench_kernel)(const struct bench_input *in);
+
+volatile uint32_t bench_sink; //keeps predictions from being optimized away
+uint8_t *bench_counters;
+
+//------------------------------------//
+//        Benchmark Functions         //
+//------------------------------------//
+
+uint64_t now_ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// xorshift, synthetic inputs are the same on every run
+//
+uint32_t bench_random(uint32_t *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+// Synthetic branches: a fixed population of pcs, each with its own
+// bias, a quarter of them following a short loop pattern instead
+//
+void make_synthetic(struct bench_input *in)
+{
+  uint32_t state = 0x12345678;
+  uint32_t *static_pc = (uint32_t *)malloc(benchStaticBranches * sizeof(uint32_t));
+  uint32_t *bias = (uint32_t *)malloc(benchStaticBranches * sizeof(uint32_t));
+  for (int i = 0; i < benchStaticBranches; i++)
+  {
+    static_pc[i] = 0x400000 + (bench_random(&state) & 0xfffff);
+    bias[i] = bench_random(&state) % 100;
+  }
+
+  in->name = "synthetic";
+  in->count = benchRecords;
+  in->pc = (uint32_t *)malloc(in->count * sizeof(uint32_t));
+  in->outcome = (uint32_t *)malloc(in->count * sizeof(uint32_t));
+  size_t capacity = (size_t)in->count * 48;
+  in->text = (char *)malloc(capacity);
+  in->textLength = 0;
+  for (int i = 0; i < in->count; i++)
+  {
+    int b = bench_random(&state) % benchStaticBranches;
+    in->pc[i] = static_pc[b];
+    if (b % 4 == 0)
+      in->outcome[i] = (i % 8) != 7 ? TAKEN : NOTTAKEN;
+    else
+      in->outcome[i] = (bench_random(&state) % 100) < bias[b] ? TAKEN : NOTTAKEN;
+    in->textLength += snprintf(in->text + in->textLength, capacity - in->textLength,
+                               "0x%x\t0x%x\t%d\t1\t0\t0\t1\n", in->pc[i], in->pc[i] + 64, in->outcome[i]);
+  }
+  in->records = in->count;
+  free(static_pc);
+  free(bias);
+}
+
+// Load the first benchRecords conditional branches of a trace
+//
+int load_trace(struct bench_input *in, const char *path)
+{
+  FILE *file = fopen(path, "r");
+  if (file == NULL)
+  {
+    return 0;
+  }
+  in->name = path;
+  in->count = 0;
+  in->records = 0;
+  in->pc = (uint32_t *)malloc(benchRecords * sizeof(uint32_t));
+  in->outcome = (uint32_t *)malloc(benchRecords * sizeof(uint32_t));
+  size_t capacity = 1 << 20;
+  in->text = (char *)malloc(capacity);
+  in->textLength = 0;
+
+  char *line = NULL;
+  size_t n = 0;
+  ssize_t length;
+  while (in->count < benchRecords && (length = getline(&line, &n, file)) != -1)
+  {
+    uint32_t pc, target, outcome, condition;
+    if (sscanf(line, "0x%x\t0x%x\t%d\t%d", &pc, &target, &outcome, &condition) != 4)
+    {
+      continue;
+    }
+    if (in->textLength + length + 1 > capacity)
+    {
+      capacity *= 2;
+      in->text = (char *)realloc(in->text, capacity);
+    }
+    memcpy(in->text + in->textLength, line, length);
+    in->textLength += length;
+    in->records++;
+    if (condition)
+    {
+      in->pc[in->count] = pc;
+      in->outcome[in->count] = outcome;
+      in->count++;
+    }
+  }
+  free(line);
+  fclose(file);
+  return in->count > 0;
+}
+
+void free_input(struct bench_input *in)
+{
+  free(in->pc);
+  free(in->outcome);
+  free(in->text);
+}
+
+// kernels
+void bench_gshare_predict(const struct bench_input *in)
+{
+  uint32_t sum = 0;
+  for (int i = 0; i < in->count; i++)
+    sum += gshare_predict(in->pc[i]);
+  bench_sink = sum;
+}
+
+void bench_gshare_train(const struct bench_input *in)
+{
+  for (int i = 0; i < in->count; i++)
+    train_gshare(in->pc[i], in->outcome[i]);
+}
+
+void bench_tournament_predict(const struct bench_input *in)
+{
+  uint32_t sum = 0;
+  for (int i = 0; i < in->count; i++)
+    sum += tournament_predict(in->pc[i]);
+  bench_sink = sum;
+}
+
+void bench_tournament_train(const struct bench_input *in)
+{
+  for (int i = 0; i < in->count; i++)
+    train_tournament(in->pc[i], in->outcome[i]);
+}
+
+void bench_custom_predict(const struct bench_input *in)
+{
+  uint32_t sum = 0;
+  for (int i = 0; i < in->count; i++)
+    sum += custom_predict(in->pc[i]);
+  bench_sink = sum;
+}
+
+void bench_custom_train(const struct bench_input *in)
+{
+  for (int i = 0; i < in->count; i++)
+    train_custom(in->pc[i], in->outcome[i]);
+}
+
+void bench_counters_2b(const struct bench_input *in)
+{
+  uint32_t sum = 0;
+  for (int i = 0; i < in->count; i++)
+  {
+    uint8_t *c = &bench_counters[in->pc[i] & 0xffff];
+    sum += predict_2_bit(*c);
+    train_2b_counter(c, in->outcome[i]);
+  }
+  bench_sink = sum;
+}
+
+void bench_counters_3b(const struct bench_input *in)
+{
+  uint32_t sum = 0;
+  for (int i = 0; i < in->count; i++)
+  {
+    uint8_t *c = &bench_counters[in->pc[i] & 0xffff];
+    sum += predict_3_bit(*c);
+    train_3b_counter(c, in->outcome[i]);
+  }
+  bench_sink = sum;
+}
+
+void bench_trace_reader(const struct bench_input *in)
+{
+  uint32_t pc, target, outcome, condition, call, ret, direct;
+  uint32_t sum = 0;
+  stream = fmemopen(in->text, in->textLength, "r");
+  while (read_branch(&pc, &target, &outcome, &condition, &call, &ret, &direct))
+    sum += pc;
+  close_trace();
+  bench_sink = sum;
+}
+
+int compare_double(const void *a, const void *b)
+{
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// One warmup run, then benchReps timed runs reported as ns per item,
+// 'items' being the branches or records one run of the kernel handles
+//
+void run_bench(const char *name, bench_kernel kernel, const struct bench_input *in, int items)
+{
+  double *ns = (double *)malloc(benchReps * sizeof(double));
+  kernel(in);
+  for (int r = 0; r < benchReps; r++)
+  {
+    uint64_t start = now_ns();
+    kernel(in);
+    ns[r] = (double)(now_ns() - start) / items;
+  }
+  qsort(ns, benchReps, sizeof(double), compare_double);
+  double mean = 0, var = 0;
+  for (int r = 0; r < benchReps; r++)
+    mean += ns[r];
+  mean /= benchReps;
+  for (int r = 0; r < benchReps; r++)
+    var += (ns[r] - mean) * (ns[r] - mean);
+  double stddev = benchReps > 1 ? sqrt(var / (benchReps - 1)) : 0;
+  printf("%-34s %-12.12s %9.2f %9.2f %9.2f %9.2f\n", name, in->name, mean, ns[benchReps / 2], ns[0], stddev);
+  free(ns);
+}
+
+void run_suite(const struct bench_input *in)
+{
+  bpType = GSHARE;
+  init_gshare();
+  run_bench("gshare_predict", bench_gshare_predict, in, in->count);
+  run_bench("train_gshare", bench_gshare_train, in, in->count);
+  cleanup_gshare();
+
+  bpType = TOURNAMENT;
+  init_tournament();
+  run_bench("tournament_predict", bench_tournament_predict, in, in->count);
+  run_bench("train_tournament", bench_tournament_train, in, in->count);
+  cleanup_tournament();
+
+  bpType = CUSTOM;
+  for (int type = CUSTOM_TOURNAMENT; type <= CUSTOM_BIMODE; type++)
+  {
+    char name[64];
+    customType = type;
+    init_custom();
+    snprintf(name, sizeof(name), "custom_predict %s", customName[type]);
+    run_bench(name, bench_custom_predict, in, in->count);
+    snprintf(name, sizeof(name), "train_custom %s", customName[type]);
+    run_bench(name, bench_custom_train, in, in->count);
+    cleanup_custom();
+  }
+
+  memset(bench_counters, WN, 1 << 16);
+  run_bench("2-bit counter", bench_counters_2b, in, in->count);
+  run_bench("3-bit counter", bench_counters_3b, in, in->count);
+  //the reader goes through every record, not just the conditional ones
+  run_bench("read_branch (per record)", bench_trace_reader, in, in->records);
+}
+
+void usage()
+{
+  fprintf(stderr, "Usage: predictor_bench <options> [<trace>...]\n");
+  fprintf(stderr, " Options:\n");
+  fprintf(stderr, " --reps:<n>     Timed repetitions per benchmark (default 10)\n");
+  fprintf(stderr, " --records:<n>  Conditional branches per input (default 1048576)\n");
+  fprintf(stderr, " Traces must be uncompressed, synthetic input always runs\n");
+}
+
+int main(int argc, char *argv[])
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!strncmp(argv[i], "--reps:", 7) && sscanf(argv[i] + 7, "%d", &benchReps) == 1 && benchReps > 0)
+      continue;
+    if (!strncmp(argv[i], "--records:", 10) && sscanf(argv[i] + 10, "%d", &benchRecords) == 1 && benchRecords > 0)
+      continue;
+    if (!strncmp(argv[i], "--", 2))
+    {
+      usage();
+      exit(strcmp(argv[i], "--help") ? 1 : 0);
+    }
+  }
+
+  bench_counters = (uint8_t *)malloc(1 << 16);
+  printf("%-34s %-12s %9s %9s %9s %9s\n", "Benchmark (ns/branch)", "Input", "Mean", "Median", "Min", "Stddev");
+
+  struct bench_input synthetic;
+  make_synthetic(&synthetic);
+  run_suite(&synthetic);
+  free_input(&synthetic);
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!strncmp(argv[i], "--", 2))
+      continue;
+    struct bench_input trace;
+    if (!load_trace(&trace, argv[i]))
+    {
+      fprintf(stderr, "Warning: no branches read from %s\n", argv[i]);
+      continue;
+    }
+    run_suite(&trace);
+    free_input(&trace);
+  }
+  free(bench_counters);
+  return 0;
+}
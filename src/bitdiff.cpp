@@ -0,0 +1,142 @@
+//========================================================//
+//  bitdiff.cpp                                           //
+//  Compare two prediction streams                        //
+//                                                        //
+//  Reads two --dump files block by block and counts the  //
+//  branches where they disagree with word wide XOR and   //
+//  popcount                                              //
+//========================================================//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "stats.h"
+
+#define BLOCK_WORDS (1 << 17) // 1 MB of each stream per read
+
+struct stream
+{
+  const char *path;
+  FILE *file;
+  uint64_t branches;
+  uint64_t *block;
+};
+
+int listCount = 0; // differing branches to print
+
+void open_stream(struct stream *s, const char *path)
+{
+  char magic[4];
+  s->path = path;
+  s->file = fopen(path, "rb");
+  if (s->file == NULL || fread(magic, 1, 4, s->file) != 4 || memcmp(magic, STREAM_MAGIC, 4) ||
+      fread(&s->branches, sizeof(s->branches), 1, s->file) != 1)
+  {
+    fprintf(stderr, "%s is not a prediction stream\n", path);
+    exit(2);
+  }
+  s->block = (uint64_t *)malloc(BLOCK_WORDS * sizeof(uint64_t));
+}
+
+void read_block(struct stream *s, uint64_t words)
+{
+  if (fread(s->block, sizeof(uint64_t), words, s->file) != words)
+  {
+    fprintf(stderr, "%s is truncated\n", s->path);
+    exit(2);
+  }
+}
+
+void usage()
+{
+  fprintf(stderr, "Usage: bitdiff <options> <dump> <dump>\n");
+  fprintf(stderr, " Compares two predictor --dump streams, exits 1 when they differ\n");
+  fprintf(stderr, " Options:\n");
+  fprintf(stderr, " --list:<n>   Print the first <n> differing branches\n");
+}
+
+int main(int argc, char *argv[])
+{
+  const char *paths[2];
+  int numPaths = 0;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!strncmp(argv[i], "--list:", 7) && sscanf(argv[i] + 7, "%d", &listCount) == 1 && listCount >= 0)
+      continue;
+    if (!strncmp(argv[i], "--", 2) || numPaths == 2)
+    {
+      usage();
+      exit(2);
+    }
+    paths[numPaths++] = argv[i];
+  }
+  if (numPaths != 2)
+  {
+    usage();
+    exit(2);
+  }
+
+  struct stream a, b;
+  open_stream(&a, paths[0]);
+  open_stream(&b, paths[1]);
+
+  //only the common prefix is compared bit by bit
+  uint64_t common = a.branches < b.branches ? a.branches : b.branches;
+  uint64_t words = (common + 63) / 64;
+  uint64_t differ = 0;
+  uint64_t onlyA = 0; // predicted taken by the first stream only
+  uint64_t first = UINT64_MAX;
+  int listed = 0;
+
+  for (uint64_t done = 0; done < words;)
+  {
+    uint64_t n = (words - done < BLOCK_WORDS) ? words - done : BLOCK_WORDS;
+    read_block(&a, n);
+    read_block(&b, n);
+    for (uint64_t w = 0; w < n; w++)
+    {
+      uint64_t x = a.block[w] ^ b.block[w];
+      if (done + w == words - 1 && (common & 63))
+      {
+        x &= (1ull << (common & 63)) - 1;
+      }
+      if (x == 0)
+      {
+        continue;
+      }
+      differ += __builtin_popcountll(x);
+      onlyA += __builtin_popcountll(x & a.block[w]);
+      if (first == UINT64_MAX)
+      {
+        first = (done + w) * 64 + __builtin_ctzll(x);
+      }
+      while (x && listed < listCount)
+      {
+        uint64_t branch = (done + w) * 64 + __builtin_ctzll(x);
+        printf("branch %llu: %d %d\n", (unsigned long long)branch,
+               (int)((a.block[w] >> (branch & 63)) & 1), (int)((b.block[w] >> (branch & 63)) & 1));
+        x &= x - 1;
+        listed++;
+      }
+    }
+    done += n;
+  }
+
+  printf("Branches:        %10llu %10llu\n", (unsigned long long)a.branches, (unsigned long long)b.branches);
+  printf("Differing:       %10llu\n", (unsigned long long)differ);
+  printf("Difference Rate: %10.3f\n", common ? 1000 * (double)differ / (double)common : 0);
+  printf("Taken Only In:   %10llu %10llu\n", (unsigned long long)onlyA, (unsigned long long)(differ - onlyA));
+  if (first != UINT64_MAX)
+  {
+    printf("First Divergence: branch %llu\n", (unsigned long long)first);
+  }
+  if (a.branches != b.branches)
+  {
+    printf("Streams differ in length after branch %llu\n", (unsigned long long)common);
+  }
+
+  fclose(a.file);
+  fclose(b.file);
+  return (differ || a.branches != b.branches) ? 1 : 0;
+}
@@ -8,10 +8,27 @@
 #include <stdlib.h>
 #include <string.h>
 #include "predictor.h"
+#include "target.h"
+#include "stats.h"
+#include "trace.h"
 
-FILE *stream;
-char *buf = NULL;
-size_t len = 0;
+// Results of the trace loop
+uint64_t num_records = 0;
+uint32_t num_branches = 0;     // scored conditional branches, after the warmup
+uint64_t all_branches = 0;     // every conditional branch
+uint64_t warmup_records = 0;   // records read by the end of the warmup
+uint32_t mispredictions = 0;
+uint64_t num_indirect = 0;
+uint64_t target_mispredictions = 0;
+uint64_t num_returns = 0;
+uint64_t return_mispredictions = 0;
+const char *trace_path = NULL; // NULL when reading stdin
+
+// Predictor checkpoints
+const char *save_path = NULL;
+uint64_t save_at = 0;          // conditional branch to save after, 0 for the end
+const char *load_path = NULL;
+uint64_t loaded_branches = 0;  // branches the loaded state was trained on
 
 // Print out the Usage information to stderr
 //
@@ -19,14 +36,180 @@ void usage()
 {
   fprintf(stderr, "Usage: predictor <options> [<trace>]\n");
   fprintf(stderr, "       bunzip2 -kc trace.bz2 | predictor <options>\n");
+  fprintf(stderr, "       Text traces and tracegen --binary traces are both accepted\n");
   fprintf(stderr, " Options:\n");
   fprintf(stderr, " --help       Print this message\n");
-  fprintf(stderr, " --verbose    Print predictions on stdout\n");
+  fprintf(stderr, " --verbose    Print predictions on stdout (see --dump for large traces)\n");
   fprintf(stderr, " --<type>     Branch prediction scheme:\n");
   fprintf(stderr, "    static\n"
                   "    gshare\n"
                   "    tournament\n"
-                  "    custom\n");
+                  "    custom[:<name>]\n"
+                  "    yags[:<historyBits>:<choiceBits>:<cacheBits>:<tagBits>]\n");
+  fprintf(stderr, " --sc[:<tableBits>]\n"
+                  "              Statistical corrector behind the selected scheme\n");
+  fprintf(stderr, " --loop[:<indexBits>:<tagBits>]\n"
+                  "              Loop predictor in front of the selected scheme\n");
+  fprintf(stderr, " --override[:<fastHistoryBits>:<latency>]\n"
+                  "              Use gshare as a fast predictor overridden by the\n"
+                  "              selected scheme <latency> cycles later\n");
+  fprintf(stderr, " --delay:<n>  Train tables <n> branches after prediction,\n"
+                  "              with speculative history update and repair\n");
+  fprintf(stderr, " --ittage[:<tableBits>]\n"
+                  "              Also predict indirect jump and call targets\n");
+  fprintf(stderr, " --ras[:<depth>[:wrap|drop]]\n"
+                  "              Also predict return targets with a return address stack\n");
+  fprintf(stderr, " --btb[:<setBits>:<ways>:<tagBits>[:lru|srrip|random]]\n"
+                  "              Model a branch target buffer fed by taken branches\n");
+  fprintf(stderr, " --profile[:<n>]\n"
+                  "              Print the <n> branches with the most mispredictions\n");
+  fprintf(stderr, " --profile-sketch[:<n>]\n"
+                  "              Same, counted in fixed memory for huge traces\n");
+  fprintf(stderr, " --instructions:<n|file>\n"
+                  "              Instruction count for MPKI, or the gen_trace.sh\n"
+                  "              sidecar holding it (found next to <trace> by default)\n");
+  fprintf(stderr, " --alias      Report table conflicts and counter occupancy\n"
+                  "              of the gshare and tournament tables\n");
+  fprintf(stderr, " --chooser[:<n>]\n"
+                  "              Attribute tournament predictions to the chooser's pick,\n"
+                  "              with the <n> most executed branches\n");
+  fprintf(stderr, " --warmup:<n> Train on the first <n> conditional branches without\n"
+                  "              scoring them (intervals and dumps still cover them)\n");
+  fprintf(stderr, " --region:<first>:<last>\n"
+                  "              Also score conditional branches <first> to <last>-1\n"
+                  "              on their own, counted from 0 with the warmup; repeatable\n");
+  fprintf(stderr, " --interval:<n>[:<file>]\n"
+                  "              Write a CSV row every <n> conditional branches\n"
+                  "              to <file>, or stdout before the summary\n");
+  fprintf(stderr, " --dump:<file>\n"
+                  "              Write predictions to <file> as a packed bitstream,\n"
+                  "              one bit per conditional branch, for bitdiff\n");
+  fprintf(stderr, " --golden-check:<file>\n"
+                  "              Compare predictions with a recorded stream, report the\n"
+                  "              first diverging branch and exit 1 on a mismatch\n");
+  fprintf(stderr, " --json[:<file>]\n"
+                  "              Write the results as JSON to <file>, or to stdout\n"
+                  "              in place of the text report\n");
+  fprintf(stderr, " --save:<file>[:<n>]\n"
+                  "              Save the predictor state after <n> conditional\n"
+                  "              branches, or at the end of the trace\n");
+  fprintf(stderr, " --load:<file>\n"
+                  "              Start from a saved predictor state instead of cold\n"
+                  "              tables, the setup must match the saved one\n");
+  fprintf(stderr, " --stats      Report where the simulator spends its time\n");
+  fprintf(stderr, " --perf       Report host hardware counters for trace ingest\n"
+                  "              and simulation (perf_event_open)\n");
+  fprintf(stderr, " Custom predictors:\n");
+  fprintf(stderr, "    tournament (default)\n"
+                  "    perceptron[:<historyBits>:<indexBits>]\n"
+                  "    hashed[:<tableBits>][:<feature>,<feature>,...]\n"
+                  "      features: bias, pc, g<a>-<b> (global history bits),\n"
+                  "                l<a>-<b> (local history bits), p<n> (path)\n"
+                  "    gskew[:<bankBits>:<historyBits>]\n"
+                  "    bimode[:<choiceBits>:<directionBits>:<historyBits>]\n");
+}
+
+// Process the ":<name>[:<params>]" suffix of --custom and select
+// the predictor that fills the custom slot
+//
+// Returns True if Successful
+//
+int handle_custom_option(const char *arg)
+{
+  if (*arg == '\0' || !strcmp(arg, ":tournament"))
+  {
+    customType = CUSTOM_TOURNAMENT;
+  }
+  else if (!strncmp(arg, ":perceptron", 11))
+  {
+    customType = CUSTOM_PERCEPTRON;
+    if (arg[11] == ':')
+    {
+      if (sscanf(arg + 12, "%d:%d", &perceptronHistoryBits, &perceptronIndexBits) != 2)
+      {
+        return 0;
+      }
+    }
+    else if (arg[11] != '\0')
+    {
+      return 0;
+    }
+    if (perceptronHistoryBits < 1 || perceptronHistoryBits > 255 ||
+        perceptronIndexBits < 0 || perceptronIndexBits > 20)
+    {
+      return 0;
+    }
+  }
+  else if (!strncmp(arg, ":hashed", 7))
+  {
+    customType = CUSTOM_HASHED;
+    arg += 7;
+    int used = 0;
+    if (sscanf(arg, ":%d%n", &hpTableBits, &used) == 1)
+    {
+      arg += used;
+      if (hpTableBits < 1 || hpTableBits > 24)
+      {
+        return 0;
+      }
+    }
+    if (*arg == ':')
+    {
+      if (!hp_parse_features(arg + 1))
+      {
+        return 0;
+      }
+    }
+    else if (*arg != '\0')
+    {
+      return 0;
+    }
+  }
+  else if (!strncmp(arg, ":gskew", 6))
+  {
+    customType = CUSTOM_GSKEW;
+    if (arg[6] == ':')
+    {
+      if (sscanf(arg + 7, "%d:%d", &gskewBankBits, &gskewHistoryBits) != 2)
+      {
+        return 0;
+      }
+    }
+    else if (arg[6] != '\0')
+    {
+      return 0;
+    }
+    if (gskewBankBits < 2 || gskewBankBits > 24 || gskewHistoryBits < 0 || gskewHistoryBits > 63)
+    {
+      return 0;
+    }
+  }
+  else if (!strncmp(arg, ":bimode", 7))
+  {
+    customType = CUSTOM_BIMODE;
+    if (arg[7] == ':')
+    {
+      if (sscanf(arg + 8, "%d:%d:%d", &bimodeChoiceBits, &bimodeDirBits, &bimodeHistoryBits) != 3)
+      {
+        return 0;
+      }
+    }
+    else if (arg[7] != '\0')
+    {
+      return 0;
+    }
+    if (bimodeChoiceBits < 0 || bimodeChoiceBits > 24 || bimodeDirBits < 0 || bimodeDirBits > 24 ||
+        bimodeHistoryBits < 0 || bimodeHistoryBits > 63)
+    {
+      return 0;
+    }
+  }
+  else
+  {
+    return 0;
+  }
+
+  return 1;
 }
 
 // Process an option and update the predictor
@@ -51,6 +234,303 @@ int handle_option(char *arg)
   else if (!strncmp(arg, "--custom", 8))
   {
     bpType = CUSTOM;
+    if (!handle_custom_option(arg + 8))
+    {
+      return 0;
+    }
+  }
+  else if (!strncmp(arg, "--yags", 6))
+  {
+    bpType = YAGS;
+    if (arg[6] == ':')
+    {
+      if (sscanf(arg + 7, "%d:%d:%d:%d", &yagsHistoryBits, &yagsChoiceBits,
+                 &yagsCacheBits, &yagsTagBits) != 4)
+      {
+        return 0;
+      }
+      if (yagsHistoryBits < 0 || yagsHistoryBits > 32 ||
+          yagsChoiceBits < 0 || yagsChoiceBits > 24 ||
+          yagsCacheBits < 0 || yagsCacheBits > 24 ||
+          yagsTagBits < 0 || yagsTagBits > 16)
+      {
+        return 0;
+      }
+    }
+    else if (arg[6] != '\0')
+    {
+      return 0;
+    }
+  }
+  else if (!strncmp(arg, "--sc", 4))
+  {
+    scEnabled = 1;
+    if (arg[4] == ':')
+    {
+      if (sscanf(arg + 5, "%d", &scTableBits) != 1 || scTableBits < 1 || scTableBits > 24)
+      {
+        return 0;
+      }
+    }
+    else if (arg[4] != '\0')
+    {
+      return 0;
+    }
+  }
+  else if (!strncmp(arg, "--loop", 6))
+  {
+    loopEnabled = 1;
+    if (arg[6] == ':')
+    {
+      if (sscanf(arg + 7, "%d:%d", &loopIndexBits, &loopTagBits) != 2)
+      {
+        return 0;
+      }
+      if (loopIndexBits < 0 || loopIndexBits > 16 || loopTagBits < 1 || loopTagBits > 15)
+      {
+        return 0;
+      }
+    }
+    else if (arg[6] != '\0')
+    {
+      return 0;
+    }
+  }
+  else if (!strncmp(arg, "--override", 10))
+  {
+    overrideEnabled = 1;
+    if (arg[10] == ':')
+    {
+      if (sscanf(arg + 11, "%d:%d", &overrideHistoryBits, &overrideLatency) != 2 ||
+          overrideHistoryBits < 1 || overrideHistoryBits > 24 || overrideLatency < 0)
+      {
+        return 0;
+      }
+    }
+    else if (arg[10] != '\0')
+    {
+      return 0;
+    }
+  }
+  else if (!strncmp(arg, "--delay:", 8))
+  {
+    if (sscanf(arg + 8, "%d", &updateDelay) != 1 || updateDelay < 0 || updateDelay > 4096)
+    {
+      return 0;
+    }
+  }
+  else if (!strncmp(arg, "--ittage", 8))
+  {
+    ittageEnabled = 1;
+    if (arg[8] == ':')
+    {
+      int end = 0;
+      if (sscanf(arg + 9, "%d%n", &ittageTableBits, &end) != 1 || arg[9 + end] != '\0' ||
+          ittageTableBits < 1 || ittageTableBits > 20)
+      {
+        return 0;
+      }
+    }
+    else if (arg[8] != '\0')
+    {
+      return 0;
+    }
+  }
+  else if (!strncmp(arg, "--ras", 5))
+  {
+    rasEnabled = 1;
+    if (arg[5] == ':')
+    {
+      int end = 0;
+      if (sscanf(arg + 6, "%d%n", &rasDepth, &end) != 1 || rasDepth < 1 || rasDepth > 4096)
+      {
+        return 0;
+      }
+      const char *policy = arg + 6 + end;
+      if (!strcmp(policy, ":wrap"))
+        rasOverflow = RAS_WRAP;
+      else if (!strcmp(policy, ":drop"))
+        rasOverflow = RAS_DROP;
+      else if (*policy != '\0')
+        return 0;
+    }
+    else if (arg[5] != '\0')
+    {
+      return 0;
+    }
+  }
+  else if (!strncmp(arg, "--btb", 5))
+  {
+    btbEnabled = 1;
+    if (arg[5] == ':')
+    {
+      int end = 0;
+      if (sscanf(arg + 6, "%d:%d:%d%n", &btbSetBits, &btbWays, &btbTagBits, &end) != 3 ||
+          btbSetBits < 0 || btbSetBits > 20 || btbWays < 1 || btbWays > 64 ||
+          btbTagBits < 1 || btbTagBits > 31)
+      {
+        return 0;
+      }
+      const char *policy = arg + 6 + end;
+      if (!strcmp(policy, ":lru"))
+        btbReplacement = BTB_LRU;
+      else if (!strcmp(policy, ":srrip"))
+        btbReplacement = BTB_SRRIP;
+      else if (!strcmp(policy, ":random"))
+        btbReplacement = BTB_RANDOM;
+      else if (*policy != '\0')
+        return 0;
+    }
+    else if (arg[5] != '\0')
+    {
+      return 0;
+    }
+  }
+  else if (!strncmp(arg, "--instructions:", 15))
+  {
+    unsigned long long count;
+    char extra;
+    if (sscanf(arg + 15, "%llu%c", &count, &extra) == 1)
+    {
+      numInstructions = count;
+    }
+    else if (!read_instruction_file(arg + 15))
+    {
+      return 0;
+    }
+  }
+  else if (!strcmp(arg, "--stats"))
+  {
+    statsEnabled = 1;
+  }
+  else if (!strcmp(arg, "--perf"))
+  {
+    perfEnabled = 1;
+  }
+  else if (!strcmp(arg, "--alias"))
+  {
+    aliasStats = 1;
+  }
+  else if (!strncmp(arg, "--chooser", 9))
+  {
+    chooserStats = 1;
+    if (arg[9] == ':')
+    {
+      if (sscanf(arg + 10, "%d", &chooserTopN) != 1 || chooserTopN < 1)
+      {
+        return 0;
+      }
+    }
+    else if (arg[9] != '\0')
+    {
+      return 0;
+    }
+  }
+  else if (!strncmp(arg, "--warmup:", 9))
+  {
+    unsigned long long n;
+    if (sscanf(arg + 9, "%llu", &n) != 1)
+    {
+      return 0;
+    }
+    warmupBranches = n;
+  }
+  else if (!strncmp(arg, "--region:", 9))
+  {
+    unsigned long long first, last;
+    if (sscanf(arg + 9, "%llu:%llu", &first, &last) != 2 || !add_region(first, last))
+    {
+      return 0;
+    }
+  }
+  else if (!strncmp(arg, "--interval:", 11))
+  {
+    unsigned long long n;
+    int used = 0;
+    if (sscanf(arg + 11, "%llu%n", &n, &used) != 1 || n == 0)
+    {
+      return 0;
+    }
+    intervalLength = n;
+    if (arg[11 + used] == ':')
+    {
+      intervalPath = arg + 12 + used;
+    }
+    else if (arg[11 + used] != '\0')
+    {
+      return 0;
+    }
+  }
+  else if (!strncmp(arg, "--json", 6))
+  {
+    jsonEnabled = 1;
+    if (arg[6] == ':' && arg[7])
+    {
+      jsonPath = arg + 7;
+    }
+    else if (arg[6] != '\0')
+    {
+      return 0;
+    }
+  }
+  else if (!strncmp(arg, "--save:", 7) && arg[7])
+  {
+    save_path = arg + 7;
+    //a trailing :<n> is the branch to save after, the path may hold ':' itself
+    char *colon = strrchr(arg + 7, ':');
+    if (colon != NULL && colon[1] != '\0' && strspn(colon + 1, "0123456789") == strlen(colon + 1))
+    {
+      unsigned long long n;
+      sscanf(colon + 1, "%llu", &n);
+      if (n == 0)
+      {
+        return 0;
+      }
+      save_at = n;
+      *colon = '\0';
+    }
+  }
+  else if (!strncmp(arg, "--load:", 7) && arg[7])
+  {
+    load_path = arg + 7;
+  }
+  else if (!strncmp(arg, "--dump:", 7) && arg[7])
+  {
+    dumpPath = arg + 7;
+  }
+  else if (!strncmp(arg, "--golden-check:", 15) && arg[15])
+  {
+    goldenCheckPath = arg + 15;
+  }
+  else if (!strncmp(arg, "--profile-sketch", 16))
+  {
+    profileMode = PROFILE_SKETCH;
+    if (arg[16] == ':')
+    {
+      if (sscanf(arg + 17, "%d", &profileTopN) != 1 || profileTopN < 1)
+      {
+        return 0;
+      }
+    }
+    else if (arg[16] != '\0')
+    {
+      return 0;
+    }
+  }
+  else if (!strncmp(arg, "--profile", 9))
+  {
+    profileMode = PROFILE_EXACT;
+    if (arg[9] == ':')
+    {
+      if (sscanf(arg + 10, "%d", &profileTopN) != 1 || profileTopN < 1)
+      {
+        return 0;
+      }
+    }
+    else if (arg[9] != '\0')
+    {
+      return 0;
+    }
   }
   else if (!strcmp(arg, "--verbose"))
   {
@@ -64,21 +544,218 @@ int handle_option(char *arg)
   return 1;
 }
 
-// Reads a line from the input stream and extracts the
-// PC and Outcome of a branch
-//
-// Returns True if Successful
+// Predict, score and train every enabled model on one trace record
 //
-int read_branch(uint32_t *pc, uint32_t *target, uint32_t *outcome, uint32_t *condition, uint32_t *call, uint32_t *ret, uint32_t *direct)
+void simulate_branch(uint32_t pc, uint32_t target, uint32_t outcome, uint32_t condition, uint32_t call, uint32_t ret, uint32_t direct)
 {
-  if (getline(&buf, &len, stream) == -1)
+  num_records++;
+  if (condition == 1)
   {
-    return 0;
+    all_branches++;
+    scoredBranch = all_branches > warmupBranches;
+    // Make a prediction and compare with actual outcome
+    stats_phase(PHASE_PREDICT);
+    uint32_t prediction = make_prediction(pc, target, direct);
+    stats_phase(PHASE_OTHER);
+    if (scoredBranch)
+    {
+      num_branches++;
+      if (prediction != outcome)
+      {
+        mispredictions++;
+      }
+      if (profileMode != PROFILE_OFF)
+      {
+        profile_branch(pc, outcome, prediction);
+      }
+    }
+    else
+    {
+      warmup_records = num_records;
+    }
+    if (numRegions)
+    {
+      region_branch(all_branches - 1, outcome, prediction);
+    }
+    if (verbose != 0)
+    {
+      printf("%d\n", prediction);
+    }
+    if (intervalLength)
+    {
+      interval_branch(outcome, prediction);
+    }
+    if (dumpPath)
+    {
+      dump_branch(prediction);
+    }
+    if (goldenCheckPath)
+    {
+      golden_branch(pc, prediction);
+    }
   }
+  else
+  {
+    //records after the last warmup branch are scored
+    scoredBranch = all_branches >= warmupBranches;
+  }
+  stats_phase(PHASE_TARGETS);
+  // Predict indirect jump and call targets, returns and conditional
+  // branches are not counted, matching what train_ittage learns
+  if (ittageEnabled)
+  {
+    if (!condition && !direct && !ret && scoredBranch)
+    {
+      num_indirect++;
+      if (ittage_predict(pc) != target)
+      {
+        target_mispredictions++;
+      }
+    }
+    train_ittage(pc, target, outcome, condition, ret, direct);
+  }
+  // Check returns against the return address stack
+  if (rasEnabled)
+  {
+    if (ret && scoredBranch)
+    {
+      num_returns++;
+      if (!ras_return_matches(ras_predict(), target))
+      {
+        return_mispredictions++;
+      }
+    }
+    train_ras(pc, call, ret);
+  }
+  if (btbEnabled)
+  {
+    train_btb(pc, target, outcome);
+  }
+  // Train the predictor
+  stats_phase(PHASE_TRAIN);
+  train_predictor(pc, target, outcome, condition, call, ret, direct);
+  stats_phase(PHASE_OTHER);
+  if (save_at && condition && all_branches == save_at)
+  {
+    save_checkpoint(save_path, loaded_branches + all_branches);
+  }
+}
 
-  sscanf(buf, "0x%x\t0x%x\t%d\t%d\t%d\t%d\t%d\n", pc, target, outcome, condition, call, ret, direct);
+// Same trace loop, reading records in batches so the time spent
+// decompressing and parsing can be told apart from the simulation
+//
+void simulate_with_stats()
+{
+  struct trace_record
+  {
+    uint32_t pc, target, outcome, condition, call, ret, direct;
+  };
+  struct trace_record *batch = (struct trace_record *)malloc(STATS_BATCH * sizeof(struct trace_record));
+  while (1)
+  {
+    stats_begin(PHASE_INGEST);
+    int n = 0;
+    while (n < STATS_BATCH)
+    {
+      struct trace_record *r = &batch[n];
+      if (!read_branch(&r->pc, &r->target, &r->outcome, &r->condition, &r->call, &r->ret, &r->direct))
+      {
+        break;
+      }
+      n++;
+    }
+    stats_end();
+    if (n == 0)
+    {
+      break;
+    }
+    stats_begin(PHASE_OTHER);
+    for (int i = 0; i < n; i++)
+    {
+      struct trace_record *r = &batch[i];
+      simulate_branch(r->pc, r->target, r->outcome, r->condition, r->call, r->ret, r->direct);
+    }
+    stats_end();
+  }
+  free(batch);
+}
 
-  return 1;
+// Text report of the results and every enabled statistic
+//
+void print_report()
+{
+  printf("Branches:        %10d\n", num_branches);
+  printf("Incorrect:       %10d\n", mispredictions);
+  float mispredict_rate = 1000 * ((float)mispredictions / (float)num_branches);
+  printf("Misprediction Rate: %7.3f\n", mispredict_rate);
+  if (warmupBranches)
+  {
+    printf("Warmup:          %10llu branches not scored\n",
+           (unsigned long long)(all_branches < warmupBranches ? all_branches : warmupBranches));
+  }
+  if (load_path)
+  {
+    printf("Warm Start:      %10llu branches from %s\n", (unsigned long long)loaded_branches, load_path);
+  }
+  if (numInstructions)
+  {
+    //with a warmup only the scored share of the records is counted
+    const char *estimate = warmupBranches ? " (estimated)" : "";
+    printf("Instructions:    %10llu%s\n", (unsigned long long)numInstructions, estimate);
+    printf("MPKI:               %7.3f%s\n", mpki(mispredictions), estimate);
+  }
+  if (numRegions)
+  {
+    print_regions();
+  }
+  if (profileMode != PROFILE_OFF)
+  {
+    print_profile(mispredictions);
+  }
+  if (aliasStats)
+  {
+    print_alias_stats();
+  }
+  if (chooserStats)
+  {
+    print_chooser_stats();
+  }
+  if (updateDelay)
+  {
+    print_pipeline_stats();
+  }
+  if (overrideEnabled)
+  {
+    print_override_stats();
+  }
+  if (ittageEnabled)
+  {
+    print_ittage_stats(num_indirect, target_mispredictions);
+  }
+  if (rasEnabled)
+  {
+    print_ras_stats(num_returns, return_mispredictions);
+  }
+  if (btbEnabled)
+  {
+    print_btb_stats(numInstructions);
+  }
+  if (scEnabled)
+  {
+    print_sc_stats();
+  }
+  if (loopEnabled)
+  {
+    print_loop_stats();
+  }
+  if (statsEnabled)
+  {
+    print_self_stats(num_records, all_branches);
+  }
+  if (perfEnabled)
+  {
+    print_perf_stats();
+  }
 }
 
 int main(int argc, char *argv[])
@@ -109,52 +786,135 @@ int main(int argc, char *argv[])
     {
       // Use as input file
       stream = fopen(argv[i], "r");
+      trace_path = argv[i];
+      if (numInstructions == 0)
+      {
+        read_sidecar(argv[i]);
+      }
     }
   }
 
+  if (verbose && jsonEnabled && !jsonPath)
+  {
+    printf("--verbose prints predictions on stdout, give --json a file to use both\n");
+    exit(1);
+  }
+  if (chooserStats && bpType != TOURNAMENT && !(bpType == CUSTOM && customType == CUSTOM_TOURNAMENT))
+  {
+    printf("--chooser needs the tournament or custom tournament predictor\n");
+    exit(1);
+  }
+
   // Initialize the predictor
   init_predictor();
+  if (ittageEnabled)
+  {
+    init_ittage();
+  }
+  if (rasEnabled)
+  {
+    init_ras();
+  }
+  if (btbEnabled)
+  {
+    init_btb();
+  }
+  if (load_path)
+  {
+    loaded_branches = load_checkpoint(load_path);
+  }
+  if (profileMode != PROFILE_OFF)
+  {
+    init_profile();
+  }
+  if (intervalLength)
+  {
+    init_interval();
+  }
+  if (dumpPath)
+  {
+    init_dump();
+  }
+  if (goldenCheckPath)
+  {
+    init_golden();
+  }
+  if (jsonEnabled)
+  {
+    init_json();
+  }
+  if (statsEnabled)
+  {
+    init_self_stats();
+  }
+  if (perfEnabled)
+  {
+    init_perf();
+  }
 
-  uint32_t num_branches = 0;
-  uint32_t mispredictions = 0;
-  uint32_t pc = 0;
-  uint32_t target = 0;
-  uint32_t outcome = NOTTAKEN;
-  uint32_t condition = 0;
-  uint32_t call = 0;
-  uint32_t ret = 0;
-  uint32_t direct = 0;
-
-  // Reach each branch from the trace
-  while (read_branch(&pc, &target, &outcome, &condition, &call, &ret, &direct))
+  if (statsEnabled || perfEnabled)
   {
-    if (condition == 1)
+    simulate_with_stats();
+  }
+  else
+  {
+    uint32_t pc = 0;
+    uint32_t target = 0;
+    uint32_t outcome = NOTTAKEN;
+    uint32_t condition = 0;
+    uint32_t call = 0;
+    uint32_t ret = 0;
+    uint32_t direct = 0;
+
+    // Reach each branch from the trace
+    while (read_branch(&pc, &target, &outcome, &condition, &call, &ret, &direct))
     {
-      num_branches++;
-      // Make a prediction and compare with actual outcome
-      uint32_t prediction = make_prediction(pc, target, direct);
-      if (prediction != outcome)
-      {
-        mispredictions++;
-      }
-      if (verbose != 0)
-      {
-        printf("%d\n", prediction);
-      }
+      simulate_branch(pc, target, outcome, condition, call, ret, direct);
     }
-    // Train the predictor
-    train_predictor(pc, target, outcome, condition, call, ret, direct);
+  }
+
+  if (intervalLength)
+  {
+    finish_interval();
+  }
+  if (statsEnabled)
+  {
+    finish_self_stats();
+  }
+
+  if (save_path && !save_at)
+  {
+    save_checkpoint(save_path, loaded_branches + all_branches);
+  }
+  // The instruction count covers the whole trace, keep the share of
+  // the records scored after the warmup for MPKI. Branch records stand
+  // in for instructions here, so the result is an estimate
+  if (warmupBranches && num_records)
+  {
+    numInstructions = (uint64_t)((double)numInstructions * (num_records - warmup_records) / num_records);
   }
 
   // Print out the mispredict statistics
-  printf("Branches:        %10d\n", num_branches);
-  printf("Incorrect:       %10d\n", mispredictions);
-  float mispredict_rate = 1000 * ((float)mispredictions / (float)num_branches);
-  printf("Misprediction Rate: %7.3f\n", mispredict_rate);
+  if (!jsonEnabled || jsonPath)
+  {
+    print_report();
+  }
+  if (jsonEnabled)
+  {
+    write_json(trace_path, num_records, num_branches, mispredictions);
+  }
+  if (dumpPath)
+  {
+    finish_dump();
+  }
+  uint64_t golden_differ = 0;
+  if (goldenCheckPath)
+  {
+    golden_differ = finish_golden();
+  }
 
   // Cleanup
-  fclose(stream);
-  free(buf);
+  close_trace();
 
-  return 0;
+  return golden_differ ? 1 : 0;
 }
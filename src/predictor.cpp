@@ -8,7 +8,12 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdint.h>
+#include <string.h>
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
 #include "predictor.h"
+#include "target.h"
 
 //
 // TODO:Student Information
@@ -22,8 +27,10 @@ const char *email = "jgalil@ucsd.edu";
 //------------------------------------//
 
 // Handy Global for use in output routines
-const char *bpName[4] = {"Static", "Gshare",
-                         "Tournament", "Custom"};
+const char *bpName[5] = {"Static", "Gshare",
+                         "Tournament", "Custom", "YAGS"};
+const char *customName[5] = {"Tournament", "Perceptron", "Hashed Perceptron",
+                             "2bc-gskew", "Bi-Mode"};
 
 // define number of bits required for indexing the BHT here.
 int ghistoryBits = 15; // Number of bits used for Global History
@@ -34,6 +41,32 @@ int tlhistoryBits = 11;  //local history length for tournament predictor
 int clhistoryBits = 11;  //local history length for custom predictor
 int tghistoryBits = 13;  //global history length for tournament predictor
 int pcIndexBits = 11;    //index bits for tournament predictor
+int yagsHistoryBits = 11; //global history length for yags
+int yagsChoiceBits = 13;  //log2 of the yags bimodal choice table
+int yagsCacheBits = 11;   //log2 of the entries in each yags direction cache
+int yagsTagBits = 8;      //tag width of the yags direction caches
+int scEnabled = 0;        //statistical corrector behind the selected predictor
+int scTableBits = 10;     //log2 of the entries in each corrector table
+int loopEnabled = 0;      //loop predictor in front of the selected predictor
+int loopIndexBits = 4;    //log2 of the number of loop predictor sets
+int loopTagBits = 10;     //tag width of the loop predictor
+int aliasStats = 0;       //count table conflicts of gshare and tournament
+int chooserStats = 0;     //attribute tournament predictions to the chooser's pick
+int chooserTopN = 20;     //hot branches in the chooser report
+int scoredBranch = 1;     //set per branch by the driver, clear during --warmup
+int overrideEnabled = 0;  //gshare answers first, the selected predictor overrides
+int overrideLatency = 2;  //cycles until the overriding prediction is ready
+int overrideHistoryBits = 10; //global history length of the fast gshare
+int updateDelay = 0;      //branches between prediction and table update
+int customType = CUSTOM_TOURNAMENT; //predictor used in the custom slot
+int perceptronHistoryBits = 31;  //global history length for perceptron
+int perceptronIndexBits = 8;     //log2 of the number of perceptron rows
+int hpTableBits = 9;             //log2 of the entries in each hashed perceptron table
+int gskewBankBits = 13;          //log2 of the entries in each 2bc-gskew bank
+int gskewHistoryBits = 21;       //global history length for 2bc-gskew
+int bimodeChoiceBits = 14;       //log2 of the bi-mode choice table
+int bimodeDirBits = 13;          //log2 of each bi-mode direction table
+int bimodeHistoryBits = 13;      //global history length for bi-mode
 
 //------------------------------------//
 //      Predictor Data Structures     //
@@ -51,7 +84,7 @@ uint8_t *t_global_prediction_table; //table of predictions
 uint64_t t_ghistory;  //global history table
 
 //tournament local
-uint16_t *t_bht_local;
+uint16_t *t_bht_local = NULL;
 uint8_t *t_local_prediction_table;
 
 //tournament choice
@@ -62,12 +95,242 @@ uint8_t *c_bht_gshare;
 uint64_t c_ghistory;
 
 //custom local
-uint16_t *c_bht_local;
+uint16_t *c_bht_local = NULL;
 uint8_t *c_local_prediction_table;
 
 //tournament choice
 uint8_t *c_choice_predictor;
 
+//yags
+// A bimodal choice table gives each branch its bias; the tagged taken
+// and not-taken caches only hold the history contexts where a branch
+// goes against that bias.
+#define Y_TAKEN_CACHE 0
+#define Y_NOTTAKEN_CACHE 1
+#define Y_INVALID 0xff   //counter value of an empty cache entry
+uint8_t *y_choice;
+uint16_t *y_cache_tag[2];
+uint8_t *y_cache_ctr[2];
+uint64_t y_ghistory;
+
+//statistical corrector
+// Sums signed counters indexed by pc, global history and the base
+// prediction and inverts the base prediction when the sum strongly
+// disagrees. Base confidence comes from a table of resetting counters
+// that count how often the base was right in a row.
+#define SC_TABLES 4
+#define SC_CTR_MAX 31
+#define SC_CTR_MIN -32
+#define SC_CONF_MAX 15
+#define SC_THETA_INIT 12
+#define SC_THETA_STEP 32
+const int sc_historyLengths[SC_TABLES] = {0, 4, 10, 20};
+int8_t *sc_tables;       //SC_TABLES tables of 6 bit counters
+uint8_t *sc_conf;        //base confidence counters
+uint64_t sc_ghistory;
+int32_t sc_theta;
+int32_t sc_thetaCounter;
+uint64_t sc_inversions;  //base predictions the corrector flipped
+uint64_t sc_inversionsCorrect;
+
+//2bc-gskew
+// Bimodal bank plus two banks indexed with different skewing functions
+// of pc and history, so branches aliasing in one bank rarely alias in
+// the others. The meta bank picks the bimodal bank or the majority vote.
+#define GSKEW_BIM 0
+#define GSKEW_G0 1
+#define GSKEW_G1 2
+#define GSKEW_META 3
+#define GSKEW_BANKS 4
+uint8_t *gs_banks[GSKEW_BANKS]; //packed 2-bit counters
+uint64_t gs_ghistory;
+
+//bi-mode
+// The choice table splits branches into mostly taken and mostly not
+// taken, each group gets its own pc ^ history indexed direction table.
+uint8_t *bm_choice;         //packed 2-bit counters
+uint8_t *bm_direction[2];   //indexed by the choice, packed 2-bit counters
+uint64_t bm_ghistory;
+
+//aliasing statistics
+// Remembers the last branch to touch each entry of the gshare and
+// tournament tables. Next to every shared entry each branch also keeps
+// a private copy trained only by its own outcomes, the prediction the
+// entry would have made without aliasing. The local history table has
+// no counters to histogram, its private copy is a per branch history.
+#define ALIAS_MAX_TABLES 4
+#define ALIAS_UNTOUCHED 0xffffffff
+struct alias_table
+{
+  const char *name;
+  uint8_t *counters;   //predictor table for the occupancy histogram
+  uint32_t entries;
+  int counterBits;
+  uint8_t init;        //initial value of a private counter
+  uint32_t *lastPc;
+  uint64_t accesses;
+  uint64_t conflicts;  //accesses by a different branch than the last one
+  uint64_t constructive; //conflicts the shared entry got right and the private one wrong
+  uint64_t destructive;  //conflicts the private entry got right and the shared one wrong
+};
+struct alias_table alias_tables[ALIAS_MAX_TABLES];
+int alias_numTables;
+
+// Private copies, open addressing on (table, entry, pc)
+struct alias_private
+{
+  uint32_t pc;
+  uint32_t idx;
+  uint16_t value;
+  uint8_t table;
+  uint8_t used;
+};
+struct alias_private *alias_privates;
+uint64_t alias_privateSize; //power of two
+uint64_t alias_privateCount;
+
+//chooser statistics
+// Every tournament prediction is counted under the component the
+// chooser picked, split by whether the chosen and the other component
+// were right. The same counts are kept per branch, along with how
+// often the branch found its local history entry last written by
+// another branch.
+#define CHOOSER_LOCAL 0
+#define CHOOSER_GLOBAL 1
+#define CHOOSER_INIT_BITS 12
+#define CHOOSER_EMPTY 0xffffffff
+struct chooser_entry
+{
+  uint32_t pc;
+  uint64_t executed;
+  uint64_t cells[2][2][2]; //[choice][chosen right][other right]
+  uint64_t sharedHistory;  //local history entry last updated by another pc
+};
+uint64_t ch_cells[2][2][2];
+struct chooser_entry *ch_table;
+uint32_t ch_capacity;
+uint32_t ch_used;
+uint32_t *ch_historyPc;    //last pc to update each local history entry
+
+//overriding predictor
+// A small gshare of its own acts as a single cycle predictor in front
+// of the selected one. When the slow prediction arrives and disagrees,
+// fetch is redirected and the cycles spent on the fast path are lost.
+uint8_t *ov_bht;
+uint64_t ov_ghistory;
+uint32_t ov_fastPred;        //predictions of the branch in flight
+uint32_t ov_slowPred;
+uint64_t ov_fastCorrect;
+uint64_t ov_slowCorrect;
+uint64_t ov_overrides;       //slow prediction differed from the fast one
+uint64_t ov_overridesCorrect;
+uint64_t ov_branches;
+
+//delayed update pipeline
+// Branches wait in a FIFO of updateDelay entries before their tables
+// are trained. Histories are updated with the prediction at fetch and
+// repaired from the branch's checkpoint when it turns out wrong.
+#define PERCEPTRON_MAX_HISTORY 255
+struct history_checkpoint
+{
+  uint64_t ghistory;
+  uint64_t ov_ghistory;
+  uint64_t t_ghistory;
+  uint64_t c_ghistory;
+  uint64_t y_ghistory;
+  uint64_t gs_ghistory;
+  uint64_t bm_ghistory;
+  uint64_t hp_ghistory;
+  uint64_t hp_phistory;
+  uint64_t sc_ghistory;
+  uint16_t t_local;   //local histories of the checkpointed pc
+  uint16_t c_local;
+  uint16_t hp_local;
+  uint16_t l_tag;      //loop entry of the checkpointed pc, 0 when none
+  uint16_t l_specIter;
+  int8_t p_ghistory[PERCEPTRON_MAX_HISTORY + 1];
+};
+struct pipeline_entry
+{
+  uint32_t pc;
+  uint32_t prediction;
+  uint32_t outcome;
+  int scored;                           //past --warmup when predicted
+  struct history_checkpoint checkpoint; //histories before the prediction
+};
+struct pipeline_entry *pl_fifo;  //ring of updateDelay + 1 entries
+uint32_t pl_head;                //oldest in flight branch
+uint32_t pl_count;               //resolved branches waiting to train
+uint64_t pl_recoveries;
+
+//loop predictor
+// Tracks branches that go one way a fixed number of times and then the
+// other way once. After LOOP_CONF_MAX identical trips in a row it
+// overrides the main prediction.
+#define LOOP_WAYS 4
+#define LOOP_ITER_MAX 0x3fff //14 bit iteration counters
+#define LOOP_CONF_MAX 3
+#define LOOP_AGE_MAX 7
+#define LOOP_VALID 0x8000    //tag bit marking a used entry
+struct loop_entry
+{
+  uint16_t tag;
+  uint16_t trip;  //iterations of the last completed trip
+  uint16_t iter;  //iterations of the current trip
+  uint16_t specIter; //iter including branches in flight, --delay only
+  uint8_t conf;
+  uint8_t age;
+  uint8_t dir;    //direction taken while inside the loop
+};
+struct loop_entry *l_table;
+uint64_t l_overrides;        //loop prediction differed from the base
+uint64_t l_overridesCorrect;
+
+//perceptron
+// Each row holds a bias weight followed by one weight per history bit,
+// padded with zero weights up to a multiple of the simd width so the
+// dot product never needs a scalar tail.
+#define PERCEPTRON_ALIGN 32
+#define PERCEPTRON_WEIGHT_MAX 127
+#define PERCEPTRON_WEIGHT_MIN -127 //keeps the sign trick from overflowing
+int8_t *p_weights;     //rows of int8 weights, selected by pc
+int8_t *p_ghistory = NULL; //history as +1/-1, slot 0 is the constant bias input
+uint32_t p_rowLength;  //weights per row including bias and padding
+int32_t p_theta;       //training threshold
+
+//hashed perceptron
+// One int8 weight table per feature. Features are parsed from a
+// comma separated list, e.g. "bias,pc,g0-8,l0-11,p8":
+//   g<a>-<b>  global history bits [a,b)
+//   l<a>-<b>  local history bits [a,b) of this branch
+//   p<n>      path of the last n branch addresses
+#define HP_MAX_FEATURES 16
+#define HP_THETA_STEP 32
+#define HP_BIAS 0
+#define HP_PC 1
+#define HP_GLOBAL 2
+#define HP_LOCAL 3
+#define HP_PATH 4
+struct hp_feature
+{
+  uint8_t kind;
+  uint8_t start;
+  uint8_t end;
+};
+const char *hp_defaultFeatures = "bias,pc,g0-4,g4-10,g10-18,g18-28,g28-40,g40-52,l0-11,p6";
+struct hp_feature hp_features[HP_MAX_FEATURES];
+int hp_numFeatures = 0;
+int8_t *hp_weights;          //hp_numFeatures tables of 2^hpTableBits weights
+uint16_t *hp_bht_local = NULL; //per branch local histories
+uint64_t hp_ghistory;
+uint64_t hp_phistory;        //two address bits per branch
+uint32_t hp_index[HP_MAX_FEATURES]; //rows used by the last prediction
+uint64_t hp_mask[HP_MAX_FEATURES];  //bits of its source each feature hashes
+uint32_t hp_lastPc;
+int hp_lastValid;
+int32_t hp_theta;            //adaptive training threshold
+int32_t hp_thetaCounter;
+
 
 
 
@@ -246,7 +509,7 @@ void init_tournament(){
   
 }
 
-void init_custom(){
+void init_custom_tournament(){
   //gshare in tournament
   init_custom_gshare();
 
@@ -271,7 +534,7 @@ void init_custom(){
   }
 }
 
-uint32_t custom_predict(uint32_t pc){
+uint32_t custom_tournament_predict(uint32_t pc){
   //indices
   uint32_t pc_idx = pc & ((1 << pcIndexBits)-1);
   uint32_t choice_index = (pc_idx ^ c_ghistory) & ((1<<c_ghistoryBits)-1);  //gshare ghist
@@ -360,7 +623,7 @@ void train_tournament(uint32_t pc, uint32_t outcome){
   t_ghistory = ((t_ghistory << 1) | outcome) & ((1 << tghistoryBits) - 1);
 }
 
-void train_custom(uint32_t pc, uint32_t outcome){
+void train_custom_tournament(uint32_t pc, uint32_t outcome){
   //indices
   uint32_t pc_idx = pc & ((1 << pcIndexBits)-1);
   uint32_t choice_index = (pc_idx ^ c_ghistory) & ((1<<c_ghistoryBits)-1);
@@ -396,94 +659,2302 @@ void train_custom(uint32_t pc, uint32_t outcome){
   c_ghistory = ((c_ghistory << 1) | outcome) & ((1 << c_ghistoryBits) - 1);
 }
 
-void cleanup_tournament(){
-  free(t_bht_local);
-  free(t_local_prediction_table);
-  free(t_global_prediction_table);
-  free(choice_predictor);
+// budget accounting
+void check_budget(const char *name, uint64_t bits)
+{
+  if (bits > BUDGET_BITS)
+  {
+    fprintf(stderr, "Warning: %s uses %llu bits, over the %d bit budget\n",
+            name, (unsigned long long)bits, BUDGET_BITS);
+  }
 }
 
-void cleanup_gshare()
+// Storage of the selected predictor's tables and history registers
+//
+uint64_t base_budget_bits()
 {
-  free(bht_gshare);
+  switch (bpType)
+  {
+  case GSHARE:
+    return ((uint64_t)2 << ghistoryBits) + ghistoryBits;
+  case TOURNAMENT:
+    return ((uint64_t)2 << tghistoryBits) * 2 + ((uint64_t)3 << tlhistoryBits) +
+           ((uint64_t)tlhistoryBits << pcIndexBits) + tghistoryBits;
+  case YAGS:
+    return yags_budget_bits();
+  case CUSTOM:
+    switch (customType)
+    {
+    case CUSTOM_TOURNAMENT:
+      return ((uint64_t)2 << c_ghistoryBits) * 2 + ((uint64_t)3 << clhistoryBits) +
+             ((uint64_t)clhistoryBits << pcIndexBits) + c_ghistoryBits;
+    case CUSTOM_PERCEPTRON:
+      return ((uint64_t)8 * (perceptronHistoryBits + 1) << perceptronIndexBits) + perceptronHistoryBits;
+    case CUSTOM_HASHED:
+      return hp_budget_bits();
+    case CUSTOM_GSKEW:
+      return gskew_budget_bits();
+    case CUSTOM_BIMODE:
+      return bimode_budget_bits();
+    }
+  }
+  return 0;
 }
 
-void cleanup_custom(){
-  free(c_bht_local);
-  free(c_local_prediction_table);
-  free(c_choice_predictor);
-  free(c_bht_gshare);
+// The selected predictor plus the corrector, loop and fast gshare
+// tables when they are enabled
+//
+uint64_t predictor_budget_bits()
+{
+  uint64_t bits = base_budget_bits();
+  if (scEnabled)
+  {
+    bits += sc_budget_bits();
+  }
+  if (loopEnabled)
+  {
+    bits += loop_budget_bits();
+  }
+  if (overrideEnabled)
+  {
+    bits += override_budget_bits();
+  }
+  return bits;
 }
 
-void init_predictor()
+// Configuration knobs of the selected predictor and the side
+// components in use, returns how many were written to 'params'
+//
+int predictor_params(struct predictor_param *params, int max)
 {
+  int n = 0;
+#define PARAM(knob)                                 \
+  do                                                \
+  {                                                 \
+    if (n < max)                                    \
+    {                                               \
+      params[n].name = #knob;                       \
+      params[n].value = knob;                       \
+      n++;                                          \
+    }                                               \
+  } while (0)
   switch (bpType)
   {
-  case STATIC:
-    break;
   case GSHARE:
-    init_gshare();
+    PARAM(ghistoryBits);
     break;
   case TOURNAMENT:
-    init_tournament();
+    PARAM(tghistoryBits);
+    PARAM(tlhistoryBits);
+    PARAM(pcIndexBits);
     break;
-  case CUSTOM:
-    init_custom();
+  case YAGS:
+    PARAM(yagsHistoryBits);
+    PARAM(yagsChoiceBits);
+    PARAM(yagsCacheBits);
+    PARAM(yagsTagBits);
     break;
-  default:
+  case CUSTOM:
+    switch (customType)
+    {
+    case CUSTOM_TOURNAMENT:
+      PARAM(c_ghistoryBits);
+      PARAM(clhistoryBits);
+      PARAM(pcIndexBits);
+      break;
+    case CUSTOM_PERCEPTRON:
+      PARAM(perceptronHistoryBits);
+      PARAM(perceptronIndexBits);
+      break;
+    case CUSTOM_HASHED:
+      PARAM(hpTableBits);
+      PARAM(hp_numFeatures);
+      PARAM(pcIndexBits);
+      break;
+    case CUSTOM_GSKEW:
+      PARAM(gskewBankBits);
+      PARAM(gskewHistoryBits);
+      break;
+    case CUSTOM_BIMODE:
+      PARAM(bimodeChoiceBits);
+      PARAM(bimodeDirBits);
+      PARAM(bimodeHistoryBits);
+      break;
+    }
     break;
   }
+  if (scEnabled)
+  {
+    PARAM(scTableBits);
+  }
+  if (loopEnabled)
+  {
+    PARAM(loopIndexBits);
+    PARAM(loopTagBits);
+  }
+  if (overrideEnabled)
+  {
+    PARAM(overrideHistoryBits);
+    PARAM(overrideLatency);
+  }
+  if (ittageEnabled)
+  {
+    PARAM(ittageTableBits);
+  }
+  if (rasEnabled)
+  {
+    PARAM(rasDepth);
+    PARAM(rasOverflow);
+  }
+  if (btbEnabled)
+  {
+    PARAM(btbSetBits);
+    PARAM(btbWays);
+    PARAM(btbTagBits);
+    PARAM(btbReplacement);
+  }
+  PARAM(updateDelay);
+#undef PARAM
+  return n;
 }
 
-// Make a prediction for conditional branch instruction at PC 'pc'
-// Returning TAKEN indicates a prediction of taken; returning NOTTAKEN
-// indicates a prediction of not taken
+// yags functions
+// Cache entries mark an empty slot with Y_INVALID, a fifth state of
+// the 2-bit counter, so each one is charged a valid bit
 //
-uint32_t make_prediction(uint32_t pc, uint32_t target, uint32_t direct)
+uint64_t yags_budget_bits()
 {
+  uint64_t choice_bits = (uint64_t)2 << yagsChoiceBits;
+  uint64_t cache_bits = (uint64_t)(yagsTagBits + 2 + 1) << yagsCacheBits;
+  return choice_bits + 2 * cache_bits + yagsHistoryBits;
+}
 
-  // Make a prediction based on the bpType
-  switch (bpType)
+void init_yags()
+{
+  check_budget("YAGS", yags_budget_bits());
+
+  uint32_t choice_entries = 1 << yagsChoiceBits;
+  y_choice = (uint8_t *)malloc(choice_entries * sizeof(uint8_t));
+  for (int i = 0; i < choice_entries; i++)
   {
-  case STATIC:
-    return TAKEN;
-  case GSHARE:
-    return gshare_predict(pc);
-  case TOURNAMENT:
-    return tournament_predict(pc);
-  case CUSTOM:
-    return custom_predict(pc);
-  default:
-    break;
+    y_choice[i] = WN;
   }
 
-  // If there is not a compatable bpType then return NOTTAKEN
-  return NOTTAKEN;
+  uint32_t cache_entries = 1 << yagsCacheBits;
+  for (int d = 0; d < 2; d++)
+  {
+    y_cache_tag[d] = (uint16_t *)malloc(cache_entries * sizeof(uint16_t));
+    y_cache_ctr[d] = (uint8_t *)malloc(cache_entries * sizeof(uint8_t));
+    for (int i = 0; i < cache_entries; i++)
+    {
+      y_cache_tag[d][i] = 0;
+      y_cache_ctr[d][i] = Y_INVALID; //nothing cached yet
+    }
+  }
+  y_ghistory = 0;
 }
 
-// Train the predictor the last executed branch at PC 'pc' and with
-// outcome 'outcome' (true indicates that the branch was taken, false
-// indicates that the branch was not taken)
+uint32_t yags_choice_index(uint32_t pc)
+{
+  return pc & ((1 << yagsChoiceBits) - 1);
+}
+
+uint32_t yags_cache_index(uint32_t pc)
+{
+  return (pc ^ y_ghistory) & ((1 << yagsCacheBits) - 1);
+}
+
+uint16_t yags_tag(uint32_t pc)
+{
+  return pc & ((1 << yagsTagBits) - 1);
+}
+
+uint32_t yags_predict(uint32_t pc)
+{
+  uint32_t choice_pred = predict_2_bit(y_choice[yags_choice_index(pc)]);
+
+  //a taken bias looks up the not-taken exceptions and vice versa
+  int d = (choice_pred == TAKEN) ? Y_NOTTAKEN_CACHE : Y_TAKEN_CACHE;
+  uint32_t idx = yags_cache_index(pc);
+  if (y_cache_ctr[d][idx] != Y_INVALID && y_cache_tag[d][idx] == yags_tag(pc))
+  {
+    return predict_2_bit(y_cache_ctr[d][idx]);
+  }
+  return choice_pred;
+}
+
+void train_yags(uint32_t pc, uint32_t outcome)
+{
+  uint32_t choice_idx = yags_choice_index(pc);
+  uint32_t choice_pred = predict_2_bit(y_choice[choice_idx]);
+  int d = (choice_pred == TAKEN) ? Y_NOTTAKEN_CACHE : Y_TAKEN_CACHE;
+  uint32_t idx = yags_cache_index(pc);
+  uint16_t tag = yags_tag(pc);
+  int hit = y_cache_ctr[d][idx] != Y_INVALID && y_cache_tag[d][idx] == tag;
+
+  if (hit)
+  {
+    uint32_t cache_pred = predict_2_bit(y_cache_ctr[d][idx]);
+    train_2b_counter(&y_cache_ctr[d][idx], outcome);
+    //leave the bias alone when the exception already covered it
+    if (!(choice_pred != outcome && cache_pred == outcome))
+    {
+      train_2b_counter(&y_choice[choice_idx], outcome);
+    }
+  }
+  else
+  {
+    if (choice_pred != outcome)
+    {
+      //record a new exception to the bias
+      y_cache_tag[d][idx] = tag;
+      y_cache_ctr[d][idx] = (outcome == TAKEN) ? WT : WN;
+    }
+    train_2b_counter(&y_choice[choice_idx], outcome);
+  }
+
+  y_ghistory = ((y_ghistory << 1) | outcome) & ((1ull << yagsHistoryBits) - 1);
+}
+
+void cleanup_yags()
+{
+  free(y_choice);
+  for (int d = 0; d < 2; d++)
+  {
+    free(y_cache_tag[d]);
+    free(y_cache_ctr[d]);
+  }
+}
+
+// perceptron functions
+void init_perceptron()
+{
+  uint32_t rows = 1 << perceptronIndexBits;
+  uint32_t inputs = perceptronHistoryBits + 1; //history plus bias
+  p_rowLength = (inputs + PERCEPTRON_ALIGN - 1) & ~(PERCEPTRON_ALIGN - 1);
+  p_theta = (int32_t)(1.93 * perceptronHistoryBits + 14);
+
+  p_weights = (int8_t *)aligned_alloc(PERCEPTRON_ALIGN, rows * p_rowLength * sizeof(int8_t));
+  memset(p_weights, 0, rows * p_rowLength * sizeof(int8_t));
+
+  //padding inputs stay 0 so padded weights never contribute or train
+  p_ghistory = (int8_t *)aligned_alloc(PERCEPTRON_ALIGN, p_rowLength * sizeof(int8_t));
+  memset(p_ghistory, 0, p_rowLength * sizeof(int8_t));
+  p_ghistory[0] = 1;
+  for (uint32_t i = 1; i < inputs; i++)
+  {
+    p_ghistory[i] = -1; //empty history reads as not taken
+  }
+}
+
+int8_t *perceptron_row(uint32_t pc)
+{
+  uint32_t row = pc & ((1 << perceptronIndexBits) - 1);
+  return &p_weights[row * p_rowLength];
+}
+
+// Dot product of a weight row with the +1/-1 history vector
 //
+int32_t perceptron_output(const int8_t *w)
+{
+  const int8_t *x = p_ghistory;
+#if defined(__AVX2__)
+  __m256i ones = _mm256_set1_epi16(1);
+  __m256i sum = _mm256_setzero_si256();
+  for (uint32_t i = 0; i < p_rowLength; i += 32)
+  {
+    //w * x where x is +1/-1/0 is just a conditional negate
+    __m256i prod = _mm256_sign_epi8(_mm256_load_si256((const __m256i *)&w[i]),
+                                    _mm256_load_si256((const __m256i *)&x[i]));
+    __m256i lo = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(prod));
+    __m256i hi = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(prod, 1));
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(lo, ones));
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(hi, ones));
+  }
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(s);
+#elif defined(__SSSE3__)
+  __m128i ones = _mm_set1_epi16(1);
+  __m128i sum = _mm_setzero_si128();
+  for (uint32_t i = 0; i < p_rowLength; i += 16)
+  {
+    __m128i prod = _mm_sign_epi8(_mm_load_si128((const __m128i *)&w[i]),
+                                 _mm_load_si128((const __m128i *)&x[i]));
+    //sign extend bytes to words by unpacking with themselves and shifting
+    __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(prod, prod), 8);
+    __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(prod, prod), 8);
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(lo, ones));
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(hi, ones));
+  }
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(sum);
+#else
+  int32_t sum = 0;
+  for (uint32_t i = 0; i < p_rowLength; i++)
+  {
+    sum += w[i] * x[i];
+  }
+  return sum;
+#endif
+}
 
-void train_predictor(uint32_t pc, uint32_t target, uint32_t outcome, uint32_t condition, uint32_t call, uint32_t ret, uint32_t direct)
+// Move every weight one step towards agreeing with the outcome
+// (w += t * x), saturating at the int8 weight limits
+//
+void perceptron_update(int8_t *w, uint32_t outcome)
 {
-  if (condition)
+  const int8_t *x = p_ghistory;
+#if defined(__AVX2__)
+  __m256i t = _mm256_set1_epi8(outcome == TAKEN ? 1 : -1);
+  __m256i wmin = _mm256_set1_epi8(PERCEPTRON_WEIGHT_MIN);
+  for (uint32_t i = 0; i < p_rowLength; i += 32)
+  {
+    __m256i delta = _mm256_sign_epi8(t, _mm256_load_si256((const __m256i *)&x[i]));
+    __m256i nw = _mm256_adds_epi8(_mm256_load_si256((const __m256i *)&w[i]), delta);
+    _mm256_store_si256((__m256i *)&w[i], _mm256_max_epi8(nw, wmin));
+  }
+#elif defined(__SSSE3__)
+  __m128i t = _mm_set1_epi8(outcome == TAKEN ? 1 : -1);
+  __m128i wlow = _mm_set1_epi8(PERCEPTRON_WEIGHT_MIN - 1);
+  for (uint32_t i = 0; i < p_rowLength; i += 16)
+  {
+    __m128i delta = _mm_sign_epi8(t, _mm_load_si128((const __m128i *)&x[i]));
+    __m128i nw = _mm_adds_epi8(_mm_load_si128((const __m128i *)&w[i]), delta);
+    //lanes that hit -128 compare as -1, subtracting that bumps them to -127
+    nw = _mm_sub_epi8(nw, _mm_cmpeq_epi8(nw, wlow));
+    _mm_store_si128((__m128i *)&w[i], nw);
+  }
+#else
+  int8_t t = (outcome == TAKEN) ? 1 : -1;
+  for (uint32_t i = 0; i < p_rowLength; i++)
+  {
+    int32_t nw = w[i] + t * x[i];
+    if (nw > PERCEPTRON_WEIGHT_MAX)
+      nw = PERCEPTRON_WEIGHT_MAX;
+    if (nw < PERCEPTRON_WEIGHT_MIN)
+      nw = PERCEPTRON_WEIGHT_MIN;
+    w[i] = (int8_t)nw;
+  }
+#endif
+}
+
+uint32_t perceptron_predict(uint32_t pc)
+{
+  return (perceptron_output(perceptron_row(pc)) >= 0) ? TAKEN : NOTTAKEN;
+}
+
+void train_perceptron(uint32_t pc, uint32_t outcome)
+{
+  int8_t *w = perceptron_row(pc);
+  int32_t y = perceptron_output(w);
+  uint32_t pred = (y >= 0) ? TAKEN : NOTTAKEN;
+
+  //train on a misprediction or when the output was not confident
+  if (pred != outcome || abs(y) <= p_theta)
+  {
+    perceptron_update(w, outcome);
+  }
+
+  //shift the history, slot 0 stays the bias input
+  memmove(&p_ghistory[2], &p_ghistory[1], perceptronHistoryBits - 1);
+  p_ghistory[1] = (outcome == TAKEN) ? 1 : -1;
+}
+
+void cleanup_perceptron()
+{
+  free(p_weights);
+  free(p_ghistory);
+  p_ghistory = NULL;
+}
+
+// hashed perceptron functions
+int hp_parse_features(const char *spec)
+{
+  hp_numFeatures = 0;
+  while (*spec != '\0')
   {
-    switch (bpType)
+    if (hp_numFeatures == HP_MAX_FEATURES)
     {
-    case STATIC:
-      return;
-    case GSHARE:
-      return train_gshare(pc, outcome);
-    case TOURNAMENT:
-      return train_tournament(pc, outcome);
-    case CUSTOM:
-      return train_custom(pc, outcome);
+      return 0;
+    }
+    struct hp_feature *f = &hp_features[hp_numFeatures];
+    int start = 0, end = 0, used = 0;
+    if (!strncmp(spec, "bias", 4))
+    {
+      f->kind = HP_BIAS;
+      used = 4;
+    }
+    else if (!strncmp(spec, "pc", 2))
+    {
+      f->kind = HP_PC;
+      used = 2;
+    }
+    //history segments must hold at least one bit, so start stays
+    //below the 64 global and 16 local history bits
+    else if (sscanf(spec, "g%d-%d%n", &start, &end, &used) == 2 && start >= 0 && start < end && end <= 64)
+    {
+      f->kind = HP_GLOBAL;
+    }
+    else if (sscanf(spec, "l%d-%d%n", &start, &end, &used) == 2 && start >= 0 && start < end && end <= 16)
+    {
+      f->kind = HP_LOCAL;
+    }
+    else if (sscanf(spec, "p%d%n", &end, &used) == 1 && end >= 1 && end <= 32)
+    {
+      f->kind = HP_PATH;
+    }
+    else
+    {
+      return 0;
+    }
+    f->start = start;
+    f->end = end;
+    hp_numFeatures++;
+
+    spec += used;
+    if (*spec == ',')
+    {
+      spec++;
+    }
+    else if (*spec != '\0')
+    {
+      return 0;
+    }
+  }
+  return hp_numFeatures > 0;
+}
+
+// Weight tables, the local history bits the features read and the
+// global and path history registers
+//
+uint64_t hp_budget_bits()
+{
+  int localBits = 0;
+  for (int f = 0; f < hp_numFeatures; f++)
+  {
+    if (hp_features[f].kind == HP_LOCAL && hp_features[f].end > localBits)
+    {
+      localBits = hp_features[f].end;
+    }
+  }
+  return ((uint64_t)8 * hp_numFeatures << hpTableBits) + ((uint64_t)localBits << pcIndexBits) + 2 * 64;
+}
+
+void init_hashed_perceptron()
+{
+  if (hp_numFeatures == 0)
+  {
+    hp_parse_features(hp_defaultFeatures);
+  }
+  check_budget("Hashed Perceptron", hp_budget_bits());
+  uint32_t entries = 1 << hpTableBits;
+  hp_weights = (int8_t *)malloc(hp_numFeatures * entries * sizeof(int8_t));
+  memset(hp_weights, 0, hp_numFeatures * entries * sizeof(int8_t));
+
+  uint32_t local_entries = 1 << pcIndexBits;
+  hp_bht_local = (uint16_t *)malloc(local_entries * sizeof(uint16_t));
+  for (int i = 0; i < local_entries; i++)
+  {
+    hp_bht_local[i] = 0;
+  }
+
+  //the segment masks are fixed by the features, so the per branch
+  //index loop needs no switch on the feature kind
+  for (int f = 0; f < hp_numFeatures; f++)
+  {
+    struct hp_feature *feat = &hp_features[f];
+    uint32_t width = feat->end - feat->start;
+    switch (feat->kind)
+    {
+    case HP_BIAS:
+      hp_mask[f] = 0;
+      break;
+    case HP_PC:
+      hp_mask[f] = ~0ull;
+      break;
+    case HP_PATH:
+      width = 2 * feat->end;
+      //fall through
     default:
+      hp_mask[f] = (width >= 64) ? ~0ull : ((1ull << width) - 1);
       break;
     }
   }
+
+  hp_ghistory = 0;
+  hp_phistory = 0;
+  hp_theta = 2 * hp_numFeatures + 8;
+  hp_thetaCounter = 0;
+  hp_lastValid = 0;
+}
+
+// Multiplicative hash of a value of any width down to hpTableBits,
+// the top bits of the product depend on every bit of the value
+//
+uint32_t hp_hash(uint64_t value)
+{
+  return (uint32_t)((value * 0x9E3779B97F4A7C15ull) >> (64 - hpTableBits));
+}
+
+// Compute the row of every feature table for this branch
+//
+void hp_compute_indices(uint32_t pc)
+{
+  uint32_t entries = 1 << hpTableBits;
+  uint32_t pc_hash = (pc ^ (pc >> hpTableBits)) & (entries - 1);
+  //indexed by feature kind
+  uint64_t sources[5] = {0, pc >> 2, hp_ghistory, hp_bht_local[pc & ((1 << pcIndexBits) - 1)], hp_phistory};
+
+  for (int f = 0; f < hp_numFeatures; f++)
+  {
+    struct hp_feature *feat = &hp_features[f];
+    uint64_t value = (sources[feat->kind] >> feat->start) & hp_mask[f];
+    hp_index[f] = f * entries + (hp_hash(value) ^ pc_hash);
+  }
+  hp_lastPc = pc;
+  hp_lastValid = 1;
+}
+
+int32_t hp_output()
+{
+  int32_t sum = 0;
+  for (int f = 0; f < hp_numFeatures; f++)
+  {
+    sum += hp_weights[hp_index[f]];
+  }
+  return sum;
+}
+
+uint32_t hashed_perceptron_predict(uint32_t pc)
+{
+  hp_compute_indices(pc);
+  return (hp_output() >= 0) ? TAKEN : NOTTAKEN;
+}
+
+void train_hashed_perceptron(uint32_t pc, uint32_t outcome)
+{
+  //reuse the rows from the prediction of this branch when possible
+  if (!hp_lastValid || hp_lastPc != pc)
+  {
+    hp_compute_indices(pc);
+  }
+  int32_t y = hp_output();
+  uint32_t pred = (y >= 0) ? TAKEN : NOTTAKEN;
+
+  if (pred != outcome || abs(y) <= hp_theta)
+  {
+    for (int f = 0; f < hp_numFeatures; f++)
+    {
+      int8_t *w = &hp_weights[hp_index[f]];
+      if (outcome == TAKEN && *w < PERCEPTRON_WEIGHT_MAX)
+        (*w)++;
+      else if (outcome == NOTTAKEN && *w > PERCEPTRON_WEIGHT_MIN)
+        (*w)--;
+    }
+
+    //adapt theta so mispredictions and low confidence updates balance
+    if (pred != outcome)
+    {
+      if (++hp_thetaCounter >= HP_THETA_STEP)
+      {
+        hp_theta++;
+        hp_thetaCounter = 0;
+      }
+    }
+    else if (--hp_thetaCounter <= -HP_THETA_STEP)
+    {
+      hp_theta--;
+      hp_thetaCounter = 0;
+    }
+  }
+
+  //history updates
+  uint32_t pc_idx = pc & ((1 << pcIndexBits) - 1);
+  hp_bht_local[pc_idx] = (hp_bht_local[pc_idx] << 1) | outcome;
+  hp_ghistory = (hp_ghistory << 1) | outcome;
+  hp_phistory = (hp_phistory << 2) | ((pc >> 2) & 3);
+  hp_lastValid = 0;
+}
+
+void cleanup_hashed_perceptron()
+{
+  free(hp_weights);
+  free(hp_bht_local);
+  hp_bht_local = NULL;
+}
+
+// statistical corrector functions
+uint64_t sc_budget_bits()
+{
+  //6 bit counters in every table, 4 bit confidence counters and
+  //the longest history any table hashes
+  return ((uint64_t)(6 * SC_TABLES + 4) << scTableBits) + sc_historyLengths[SC_TABLES - 1];
+}
+
+void init_sc()
+{
+  uint32_t entries = 1 << scTableBits;
+  sc_tables = (int8_t *)malloc(SC_TABLES * entries * sizeof(int8_t));
+  memset(sc_tables, 0, SC_TABLES * entries * sizeof(int8_t));
+  sc_conf = (uint8_t *)malloc(entries * sizeof(uint8_t));
+  memset(sc_conf, 0, entries * sizeof(uint8_t));
+  sc_ghistory = 0;
+  sc_theta = SC_THETA_INIT;
+  sc_thetaCounter = 0;
+  sc_inversions = 0;
+  sc_inversionsCorrect = 0;
+}
+
+uint32_t sc_conf_index(uint32_t pc)
+{
+  return (pc ^ sc_ghistory) & ((1 << scTableBits) - 1);
+}
+
+// Hash pc, a prefix of the global history and the base prediction
+// into each corrector table
+//
+void sc_compute_indices(uint32_t pc, uint32_t base_pred, uint32_t *idx)
+{
+  uint32_t mask = (1 << scTableBits) - 1;
+  uint32_t entries = 1 << scTableBits;
+  uint32_t high_conf = sc_conf[sc_conf_index(pc)] >= SC_CONF_MAX;
+  for (int t = 0; t < SC_TABLES; t++)
+  {
+    uint64_t hist = sc_ghistory & ((1ull << sc_historyLengths[t]) - 1);
+    uint32_t h = (uint32_t)(hist ^ (hist >> scTableBits) ^ (hist >> (2 * scTableBits)));
+    //table 0 also sees the base confidence so it can learn per branch bias
+    uint32_t extra = (t == 0) ? (high_conf << 1) : 0;
+    idx[t] = t * entries + (((pc << 2) ^ (pc >> scTableBits) ^ h ^ extra ^ base_pred) & mask);
+  }
+}
+
+int32_t sc_sum(const uint32_t *idx)
+{
+  int32_t sum = 0;
+  for (int t = 0; t < SC_TABLES; t++)
+  {
+    //centered so a zero counter still votes
+    sum += 2 * sc_tables[idx[t]] + 1;
+  }
+  return sum;
+}
+
+// Inversion threshold, raised when the base prediction is confident
+//
+int32_t sc_threshold(uint32_t pc)
+{
+  return (sc_conf[sc_conf_index(pc)] >= SC_CONF_MAX) ? 2 * sc_theta : sc_theta;
+}
+
+uint32_t sc_predict(uint32_t pc, uint32_t base_pred)
+{
+  uint32_t idx[SC_TABLES];
+  sc_compute_indices(pc, base_pred, idx);
+  int32_t sum = sc_sum(idx);
+  uint32_t sc_pred = (sum >= 0) ? TAKEN : NOTTAKEN;
+  if (sc_pred != base_pred && abs(sum) > sc_threshold(pc))
+  {
+    return sc_pred;
+  }
+  return base_pred;
+}
+
+void train_sc(uint32_t pc, uint32_t outcome, uint32_t base_pred)
+{
+  uint32_t idx[SC_TABLES];
+  sc_compute_indices(pc, base_pred, idx);
+  int32_t sum = sc_sum(idx);
+  uint32_t sc_pred = (sum >= 0) ? TAKEN : NOTTAKEN;
+
+  if (scoredBranch && sc_pred != base_pred && abs(sum) > sc_threshold(pc))
+  {
+    sc_inversions++;
+    if (sc_pred == outcome)
+    {
+      sc_inversionsCorrect++;
+    }
+  }
+
+  if (sc_pred != outcome || abs(sum) <= sc_theta)
+  {
+    for (int t = 0; t < SC_TABLES; t++)
+    {
+      int8_t *c = &sc_tables[idx[t]];
+      if (outcome == TAKEN && *c < SC_CTR_MAX)
+        (*c)++;
+      else if (outcome == NOTTAKEN && *c > SC_CTR_MIN)
+        (*c)--;
+    }
+
+    //adapt the threshold so mispredictions and weak updates balance
+    if (sc_pred != outcome)
+    {
+      if (++sc_thetaCounter >= SC_THETA_STEP)
+      {
+        sc_theta++;
+        sc_thetaCounter = 0;
+      }
+    }
+    else if (--sc_thetaCounter <= -SC_THETA_STEP && sc_theta > 1)
+    {
+      sc_theta--;
+      sc_thetaCounter = 0;
+    }
+  }
+
+  //resetting confidence counter of the base predictor
+  uint8_t *conf = &sc_conf[sc_conf_index(pc)];
+  if (base_pred == outcome)
+  {
+    saturating_add(conf, SC_CONF_MAX);
+  }
+  else
+  {
+    *conf = 0;
+  }
+
+  sc_ghistory = (sc_ghistory << 1) | outcome;
+}
+
+void print_sc_stats()
+{
+  printf("SC inversions:   %10llu\n", (unsigned long long)sc_inversions);
+  printf("SC correct:      %10llu\n", (unsigned long long)sc_inversionsCorrect);
+}
+
+void cleanup_sc()
+{
+  free(sc_tables);
+  free(sc_conf);
+}
+
+// loop predictor functions
+uint64_t loop_budget_bits()
+{
+  //tag and valid bit, trip and iteration counters, confidence, age and
+  //direction, plus the speculative iteration counter under --delay
+  uint64_t entry = loopTagBits + 1 + 14 + 14 + 2 + 3 + 1 + (updateDelay ? 14 : 0);
+  return entry * (LOOP_WAYS << loopIndexBits);
+}
+
+void init_loop()
+{
+  uint32_t entries = LOOP_WAYS << loopIndexBits;
+  l_table = (struct loop_entry *)malloc(entries * sizeof(struct loop_entry));
+  memset(l_table, 0, entries * sizeof(struct loop_entry));
+  l_overrides = 0;
+  l_overridesCorrect = 0;
+}
+
+uint16_t loop_tag(uint32_t pc)
+{
+  return ((pc >> loopIndexBits) & ((1 << loopTagBits) - 1)) | LOOP_VALID;
+}
+
+// Returns the entry tracking this branch, or NULL
+//
+struct loop_entry *loop_lookup(uint32_t pc)
+{
+  struct loop_entry *set = &l_table[(pc & ((1 << loopIndexBits) - 1)) * LOOP_WAYS];
+  uint16_t tag = loop_tag(pc);
+  for (int w = 0; w < LOOP_WAYS; w++)
+  {
+    if (set[w].tag == tag)
+    {
+      return &set[w];
+    }
+  }
+  return NULL;
+}
+
+// Prediction of a confident entry: keep going in the loop direction
+// until the learned trip count is reached, then exit
+//
+uint32_t loop_entry_predict(struct loop_entry *e, uint16_t iter)
+{
+  return (iter == e->trip) ? !e->dir : e->dir;
+}
+
+// With --delay the iterations of the branches still in flight are
+// counted in specIter, iter only moves when a branch retires
+//
+uint32_t loop_predict(uint32_t pc, uint32_t base_pred)
+{
+  struct loop_entry *e = loop_lookup(pc);
+  if (e != NULL && e->conf >= LOOP_CONF_MAX)
+  {
+    return loop_entry_predict(e, updateDelay ? e->specIter : e->iter);
+  }
+  return base_pred;
+}
+
+// Advance the speculative iteration count by a predicted or resolved
+// outcome, the counterpart of the iter update in train_loop
+//
+void loop_speculate(uint32_t pc, uint32_t outcome)
+{
+  struct loop_entry *e = loop_lookup(pc);
+  if (e == NULL)
+  {
+    return;
+  }
+  if (outcome == e->dir)
+  {
+    if (e->specIter < LOOP_ITER_MAX)
+      e->specIter++;
+  }
+  else
+  {
+    e->specIter = 0;
+  }
+}
+
+void train_loop(uint32_t pc, uint32_t outcome, uint32_t base_pred)
+{
+  struct loop_entry *e = loop_lookup(pc);
+  if (e == NULL)
+  {
+    if (base_pred == outcome)
+    {
+      return;
+    }
+    //allocate on a base misprediction, which is usually a loop exit
+    struct loop_entry *set = &l_table[(pc & ((1 << loopIndexBits) - 1)) * LOOP_WAYS];
+    for (int w = 0; w < LOOP_WAYS; w++)
+    {
+      if (set[w].age == 0)
+      {
+        set[w].tag = loop_tag(pc);
+        set[w].trip = 0;
+        set[w].iter = 0;
+        set[w].specIter = 0;
+        set[w].conf = 0;
+        set[w].age = LOOP_AGE_MAX;
+        set[w].dir = !outcome;
+        return;
+      }
+    }
+    //every way is in use, age them so stale loops get replaced
+    for (int w = 0; w < LOOP_WAYS; w++)
+    {
+      set[w].age--;
+    }
+    return;
+  }
+
+  if (e->conf >= LOOP_CONF_MAX)
+  {
+    uint32_t loop_pred = loop_entry_predict(e, e->iter);
+    if (loop_pred != base_pred)
+    {
+      l_overrides += scoredBranch;
+      if (loop_pred == outcome)
+      {
+        l_overridesCorrect += scoredBranch;
+        if (e->age < LOOP_AGE_MAX)
+          e->age++;
+      }
+    }
+    if (loop_pred != outcome)
+    {
+      //a confident loop was wrong, stop trusting it
+      e->tag = 0;
+      e->age = 0;
+      return;
+    }
+  }
+
+  if (outcome == e->dir)
+  {
+    if (e->iter == LOOP_ITER_MAX)
+    {
+      //too long to track, give the slot back
+      e->tag = 0;
+      e->age = 0;
+      return;
+    }
+    e->iter++;
+  }
+  else
+  {
+    //loop exit, check the trip count against the previous visits
+    if (e->iter == e->trip)
+    {
+      if (e->conf < LOOP_CONF_MAX)
+        e->conf++;
+    }
+    else
+    {
+      e->trip = e->iter;
+      e->conf = 0;
+    }
+    e->iter = 0;
+  }
+}
+
+void print_loop_stats()
+{
+  printf("Loop overrides:  %10llu\n", (unsigned long long)l_overrides);
+  printf("Loop correct:    %10llu\n", (unsigned long long)l_overridesCorrect);
+}
+
+void cleanup_loop()
+{
+  free(l_table);
+}
+
+// packed 2-bit counter tables, four counters per byte
+uint8_t *alloc_packed_2b(uint32_t entries, uint8_t init)
+{
+  uint32_t bytes = (entries + 3) / 4;
+  uint8_t *table = (uint8_t *)malloc(bytes * sizeof(uint8_t));
+  memset(table, init * 0x55, bytes * sizeof(uint8_t));
+  return table;
+}
+
+uint8_t packed_2b_get(const uint8_t *table, uint32_t idx)
+{
+  return (table[idx >> 2] >> ((idx & 3) * 2)) & 3;
+}
+
+void packed_2b_train(uint8_t *table, uint32_t idx, uint32_t outcome)
+{
+  uint32_t shift = (idx & 3) * 2;
+  uint8_t counter = (table[idx >> 2] >> shift) & 3;
+  train_2b_counter(&counter, outcome);
+  table[idx >> 2] = (table[idx >> 2] & ~(3 << shift)) | (counter << shift);
+}
+
+uint64_t packed_2b_bits(uint32_t entries)
+{
+  return (uint64_t)2 * entries;
+}
+
+// 2bc-gskew functions
+uint64_t gskew_budget_bits()
+{
+  return 4 * packed_2b_bits(1 << gskewBankBits) + gskewHistoryBits;
+}
+
+void init_gskew()
+{
+  check_budget("2bc-gskew", gskew_budget_bits());
+  uint32_t entries = 1 << gskewBankBits;
+  for (int b = 0; b < GSKEW_BANKS; b++)
+  {
+    gs_banks[b] = alloc_packed_2b(entries, WN);
+  }
+  gs_ghistory = 0;
+}
+
+// Seznec's skewing function H and its inverse on gskewBankBits wide values
+//
+uint32_t gskew_h(uint32_t x)
+{
+  uint32_t n = gskewBankBits;
+  uint32_t top = ((x ^ (x >> (n - 1))) & 1) << (n - 1);
+  return ((x >> 1) | top) & ((1 << n) - 1);
+}
+
+uint32_t gskew_hinv(uint32_t x)
+{
+  uint32_t n = gskewBankBits;
+  uint32_t low = ((x >> (n - 1)) ^ (x >> (n - 2))) & 1;
+  return ((x << 1) | low) & ((1 << n) - 1);
+}
+
+void gskew_indices(uint32_t pc, uint32_t *idx)
+{
+  uint32_t mask = (1 << gskewBankBits) - 1;
+  uint32_t v1 = pc & mask;
+  uint64_t hist = gs_ghistory;
+  uint32_t v2 = 0;
+  while (hist)
+  {
+    v2 ^= hist & mask; //fold long histories into one bank index
+    hist >>= gskewBankBits;
+  }
+  idx[GSKEW_BIM] = v1;
+  idx[GSKEW_G0] = gskew_h(v1) ^ gskew_hinv(v2) ^ v2;
+  idx[GSKEW_G1] = gskew_h(v1) ^ gskew_hinv(v2) ^ v1;
+  idx[GSKEW_META] = gskew_hinv(v1) ^ gskew_h(v2) ^ v2;
+}
+
+uint32_t gskew_predict(uint32_t pc)
+{
+  uint32_t idx[GSKEW_BANKS];
+  gskew_indices(pc, idx);
+  uint32_t bim = predict_2_bit(packed_2b_get(gs_banks[GSKEW_BIM], idx[GSKEW_BIM]));
+  uint32_t g0 = predict_2_bit(packed_2b_get(gs_banks[GSKEW_G0], idx[GSKEW_G0]));
+  uint32_t g1 = predict_2_bit(packed_2b_get(gs_banks[GSKEW_G1], idx[GSKEW_G1]));
+  uint32_t vote = (bim + g0 + g1) >= 2 ? TAKEN : NOTTAKEN;
+  //meta taken selects the majority vote, else the bimodal bank
+  uint32_t use_vote = predict_2_bit(packed_2b_get(gs_banks[GSKEW_META], idx[GSKEW_META]));
+  return use_vote ? vote : bim;
+}
+
+void train_gskew(uint32_t pc, uint32_t outcome)
+{
+  uint32_t idx[GSKEW_BANKS];
+  gskew_indices(pc, idx);
+  uint32_t pred[3];
+  for (int b = 0; b < 3; b++)
+  {
+    pred[b] = predict_2_bit(packed_2b_get(gs_banks[b], idx[b]));
+  }
+  uint32_t vote = (pred[0] + pred[1] + pred[2]) >= 2 ? TAKEN : NOTTAKEN;
+  uint32_t use_vote = predict_2_bit(packed_2b_get(gs_banks[GSKEW_META], idx[GSKEW_META]));
+  uint32_t final_pred = use_vote ? vote : pred[GSKEW_BIM];
+
+  if (final_pred == outcome)
+  {
+    //partial update: only strengthen the banks that gave the prediction
+    if (use_vote)
+    {
+      for (int b = 0; b < 3; b++)
+      {
+        if (pred[b] == outcome)
+          packed_2b_train(gs_banks[b], idx[b], outcome);
+      }
+    }
+    else
+    {
+      packed_2b_train(gs_banks[GSKEW_BIM], idx[GSKEW_BIM], outcome);
+    }
+  }
+  else
+  {
+    for (int b = 0; b < 3; b++)
+    {
+      packed_2b_train(gs_banks[b], idx[b], outcome);
+    }
+  }
+
+  //meta learns which side to trust when they disagree
+  if (vote != pred[GSKEW_BIM])
+  {
+    packed_2b_train(gs_banks[GSKEW_META], idx[GSKEW_META], vote == outcome ? TAKEN : NOTTAKEN);
+  }
+
+  gs_ghistory = ((gs_ghistory << 1) | outcome) & ((1ull << gskewHistoryBits) - 1);
+}
+
+void cleanup_gskew()
+{
+  for (int b = 0; b < GSKEW_BANKS; b++)
+  {
+    free(gs_banks[b]);
+  }
+}
+
+// bi-mode functions
+uint64_t bimode_budget_bits()
+{
+  return packed_2b_bits(1 << bimodeChoiceBits) + 2 * packed_2b_bits(1 << bimodeDirBits) + bimodeHistoryBits;
+}
+
+void init_bimode()
+{
+  check_budget("Bi-Mode", bimode_budget_bits());
+  bm_choice = alloc_packed_2b(1 << bimodeChoiceBits, WN);
+  bm_direction[NOTTAKEN] = alloc_packed_2b(1 << bimodeDirBits, WN);
+  bm_direction[TAKEN] = alloc_packed_2b(1 << bimodeDirBits, WT);
+  bm_ghistory = 0;
+}
+
+uint32_t bimode_direction_index(uint32_t pc)
+{
+  return (pc ^ bm_ghistory) & ((1 << bimodeDirBits) - 1);
+}
+
+uint32_t bimode_predict(uint32_t pc)
+{
+  uint32_t choice = predict_2_bit(packed_2b_get(bm_choice, pc & ((1 << bimodeChoiceBits) - 1)));
+  return predict_2_bit(packed_2b_get(bm_direction[choice], bimode_direction_index(pc)));
+}
+
+void train_bimode(uint32_t pc, uint32_t outcome)
+{
+  uint32_t choice_idx = pc & ((1 << bimodeChoiceBits) - 1);
+  uint32_t dir_idx = bimode_direction_index(pc);
+  uint32_t choice = predict_2_bit(packed_2b_get(bm_choice, choice_idx));
+  uint32_t pred = predict_2_bit(packed_2b_get(bm_direction[choice], dir_idx));
+
+  //only the selected direction table is trained
+  packed_2b_train(bm_direction[choice], dir_idx, outcome);
+
+  //leave the choice alone when it was wrong but the direction table covered it
+  if (!(choice != outcome && pred == outcome))
+  {
+    packed_2b_train(bm_choice, choice_idx, outcome);
+  }
+
+  bm_ghistory = ((bm_ghistory << 1) | outcome) & ((1ull << bimodeHistoryBits) - 1);
+}
+
+void cleanup_bimode()
+{
+  free(bm_choice);
+  free(bm_direction[NOTTAKEN]);
+  free(bm_direction[TAKEN]);
+}
+
+// aliasing statistics functions
+void alias_init_table(struct alias_table *t, const char *name, uint8_t *counters,
+                      uint32_t entries, int counter_bits, uint8_t init)
+{
+  t->name = name;
+  t->counters = counters;
+  t->entries = entries;
+  t->counterBits = counter_bits;
+  t->init = init;
+  t->lastPc = (uint32_t *)malloc(entries * sizeof(uint32_t));
+  for (uint32_t i = 0; i < entries; i++)
+  {
+    t->lastPc[i] = ALIAS_UNTOUCHED;
+  }
+  t->accesses = 0;
+  t->conflicts = 0;
+  t->constructive = 0;
+  t->destructive = 0;
+}
+
+void init_alias()
+{
+  alias_numTables = 0;
+  switch (bpType)
+  {
+  case GSHARE:
+    alias_init_table(&alias_tables[alias_numTables++], "gshare BHT", bht_gshare, 1 << ghistoryBits, 2, WN);
+    break;
+  case TOURNAMENT:
+    alias_init_table(&alias_tables[alias_numTables++], "global", t_global_prediction_table, 1 << tghistoryBits, 2, WT);
+    alias_init_table(&alias_tables[alias_numTables++], "local history", NULL, 1 << pcIndexBits, 0, 0);
+    alias_init_table(&alias_tables[alias_numTables++], "local pattern", t_local_prediction_table, 1 << tlhistoryBits, 3, 4);
+    alias_init_table(&alias_tables[alias_numTables++], "choice", choice_predictor, 1 << tghistoryBits, 2, WN);
+    break;
+  default:
+    break;
+  }
+  alias_privateSize = 1 << 16;
+  alias_privateCount = 0;
+  alias_privates = (struct alias_private *)calloc(alias_privateSize, sizeof(struct alias_private));
+}
+
+uint64_t alias_hash(int table, uint32_t idx, uint32_t pc)
+{
+  uint64_t h = ((uint64_t)pc << 32 | idx) ^ ((uint64_t)table << 61);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  return h;
+}
+
+// Find the private copy of entry 'idx' of table 'table' for 'pc',
+// creating it with the table's initial value on first use
+//
+uint16_t *alias_private_value(int table, uint32_t idx, uint32_t pc)
+{
+  if (2 * (alias_privateCount + 1) > alias_privateSize)
+  {
+    struct alias_private *old = alias_privates;
+    uint64_t oldSize = alias_privateSize;
+    alias_privateSize *= 2;
+    alias_privates = (struct alias_private *)calloc(alias_privateSize, sizeof(struct alias_private));
+    for (uint64_t i = 0; i < oldSize; i++)
+    {
+      if (!old[i].used)
+        continue;
+      uint64_t h = alias_hash(old[i].table, old[i].idx, old[i].pc) & (alias_privateSize - 1);
+      while (alias_privates[h].used)
+        h = (h + 1) & (alias_privateSize - 1);
+      alias_privates[h] = old[i];
+    }
+    free(old);
+  }
+  uint64_t h = alias_hash(table, idx, pc) & (alias_privateSize - 1);
+  while (alias_privates[h].used)
+  {
+    struct alias_private *p = &alias_privates[h];
+    if (p->table == table && p->idx == idx && p->pc == pc)
+      return &p->value;
+    h = (h + 1) & (alias_privateSize - 1);
+  }
+  struct alias_private *p = &alias_privates[h];
+  p->used = 1;
+  p->table = table;
+  p->idx = idx;
+  p->pc = pc;
+  p->value = alias_tables[table].init;
+  alias_privateCount++;
+  return &p->value;
+}
+
+// Record an access to entry 'idx' by 'pc'. An access conflicts when
+// another branch touched the entry last; the conflict is constructive
+// when the shared entry predicted this branch right and its private
+// copy would have been wrong, destructive in the opposite case. When
+// both agree the aliasing made no difference.
+//
+void alias_record(int table, uint32_t idx, uint32_t pc, int shared_correct, int private_correct)
+{
+  struct alias_table *t = &alias_tables[table];
+  if (scoredBranch)
+  {
+    t->accesses++;
+  }
+  if (scoredBranch && t->lastPc[idx] != pc && t->lastPc[idx] != ALIAS_UNTOUCHED)
+  {
+    t->conflicts++;
+    if (shared_correct && !private_correct)
+      t->constructive++;
+    else if (!shared_correct && private_correct)
+      t->destructive++;
+  }
+  t->lastPc[idx] = pc;
+}
+
+// Predict from a private counter and train it like the shared one
+//
+uint32_t alias_private_counter(int table, uint32_t idx, uint32_t pc, uint32_t outcome)
+{
+  uint16_t *value = alias_private_value(table, idx, pc);
+  uint8_t counter = *value;
+  uint32_t pred;
+  if (alias_tables[table].counterBits == 3)
+  {
+    pred = predict_3_bit(counter);
+    train_3b_counter(&counter, outcome);
+  }
+  else
+  {
+    pred = predict_2_bit(counter);
+    train_2b_counter(&counter, outcome);
+  }
+  *value = counter;
+  return pred;
+}
+
+// Observe a branch before its tables are trained, using the same
+// indices the predictor computes
+//
+void alias_observe(uint32_t pc, uint32_t outcome)
+{
+  if (bpType == GSHARE)
+  {
+    uint32_t bht_entries = 1 << ghistoryBits;
+    uint32_t index = (pc & (bht_entries - 1)) ^ (ghistory & (bht_entries - 1));
+    uint32_t private_pred = alias_private_counter(0, index, pc, outcome);
+    alias_record(0, index, pc, predict_2_bit(bht_gshare[index]) == outcome, private_pred == outcome);
+  }
+  else if (bpType == TOURNAMENT)
+  {
+    uint32_t pc_idx = pc & ((1 << pcIndexBits) - 1);
+    uint32_t global_idx = t_ghistory & ((1 << tghistoryBits) - 1);
+    uint32_t choice_index = (pc_idx ^ t_ghistory) & ((1 << tghistoryBits) - 1);
+    uint32_t local_pattern_idx = t_bht_local[pc_idx] & ((1 << tlhistoryBits) - 1);
+    uint32_t local_pred = predict_3_bit(t_local_prediction_table[local_pattern_idx]);
+    uint32_t global_pred = predict_2_bit(t_global_prediction_table[global_idx]);
+    uint32_t choice_pred = predict_2_bit(choice_predictor[choice_index]);
+    uint32_t chosen = (choice_pred == TAKEN) ? local_pred : global_pred;
+
+    uint32_t private_global = alias_private_counter(0, global_idx, pc, outcome);
+    alias_record(0, global_idx, pc, global_pred == outcome, private_global == outcome);
+
+    //a private local history looks up the shared pattern table
+    uint16_t *history = alias_private_value(1, 0, pc);
+    uint32_t private_local = predict_3_bit(t_local_prediction_table[*history & ((1 << tlhistoryBits) - 1)]);
+    *history = ((*history << 1) | outcome) & ((1 << tlhistoryBits) - 1);
+    alias_record(1, pc_idx, pc, local_pred == outcome, private_local == outcome);
+
+    uint32_t private_pattern = alias_private_counter(2, local_pattern_idx, pc, outcome);
+    alias_record(2, local_pattern_idx, pc, local_pred == outcome, private_pattern == outcome);
+
+    //the private choice picks between the same component predictions
+    //and is trained by the same rule as the shared one
+    uint16_t *choice = alias_private_value(3, choice_index, pc);
+    uint32_t private_chosen = (predict_2_bit(*choice) == TAKEN) ? local_pred : global_pred;
+    if (local_pred != global_pred)
+    {
+      if (local_pred == outcome && *choice < 3)
+        (*choice)++;
+      else if (global_pred == outcome && *choice > 0)
+        (*choice)--;
+    }
+    alias_record(3, choice_index, pc, chosen == outcome, private_chosen == outcome);
+  }
+}
+
+void print_alias_stats()
+{
+  for (int i = 0; i < alias_numTables; i++)
+  {
+    struct alias_table *t = &alias_tables[i];
+    uint64_t touched = 0;
+    for (uint32_t e = 0; e < t->entries; e++)
+    {
+      touched += (t->lastPc[e] != ALIAS_UNTOUCHED);
+    }
+    printf("Table %s (%u entries, %llu used):\n", t->name, t->entries, (unsigned long long)touched);
+    printf("  Accesses:      %10llu\n", (unsigned long long)t->accesses);
+    printf("  Conflicts:     %10llu (%.2f%%)\n", (unsigned long long)t->conflicts,
+           t->accesses ? 100 * ((float)t->conflicts / (float)t->accesses) : 0);
+    printf("  Constructive:  %10llu\n", (unsigned long long)t->constructive);
+    printf("  Destructive:   %10llu\n", (unsigned long long)t->destructive);
+    if (t->counters != NULL)
+    {
+      uint64_t histogram[8] = {0};
+      for (uint32_t e = 0; e < t->entries; e++)
+      {
+        histogram[t->counters[e] & 7]++;
+      }
+      printf("  Counters:     ");
+      for (int v = 0; v < (1 << t->counterBits); v++)
+      {
+        printf(" %d:%.1f%%", v, 100 * ((float)histogram[v] / (float)t->entries));
+      }
+      printf("\n");
+    }
+  }
+}
+
+void cleanup_alias()
+{
+  for (int i = 0; i < alias_numTables; i++)
+  {
+    free(alias_tables[i].lastPc);
+  }
+  free(alias_privates);
+}
+
+// chooser statistics functions
+void init_chooser()
+{
+  memset(ch_cells, 0, sizeof(ch_cells));
+  ch_capacity = 1 << CHOOSER_INIT_BITS;
+  ch_used = 0;
+  ch_table = (struct chooser_entry *)malloc(ch_capacity * sizeof(struct chooser_entry));
+  for (uint32_t i = 0; i < ch_capacity; i++)
+  {
+    ch_table[i].pc = CHOOSER_EMPTY;
+  }
+  ch_historyPc = (uint32_t *)malloc((1 << pcIndexBits) * sizeof(uint32_t));
+  for (uint32_t i = 0; i < (1u << pcIndexBits); i++)
+  {
+    ch_historyPc[i] = CHOOSER_EMPTY;
+  }
+}
+
+uint32_t chooser_slot(struct chooser_entry *table, uint32_t capacity, uint32_t pc)
+{
+  uint32_t h = pc * 0x9E3779B1;
+  uint32_t slot = (h ^ (h >> 15)) & (capacity - 1);
+  while (table[slot].pc != pc && table[slot].pc != CHOOSER_EMPTY)
+  {
+    slot = (slot + 1) & (capacity - 1);
+  }
+  return slot;
+}
+
+// Per branch entry, the table doubles at half load
+//
+struct chooser_entry *chooser_entry(uint32_t pc)
+{
+  uint32_t slot = chooser_slot(ch_table, ch_capacity, pc);
+  if (ch_table[slot].pc == CHOOSER_EMPTY)
+  {
+    if (2 * (ch_used + 1) > ch_capacity)
+    {
+      uint32_t capacity = 2 * ch_capacity;
+      struct chooser_entry *table = (struct chooser_entry *)malloc(capacity * sizeof(struct chooser_entry));
+      for (uint32_t i = 0; i < capacity; i++)
+      {
+        table[i].pc = CHOOSER_EMPTY;
+      }
+      for (uint32_t i = 0; i < ch_capacity; i++)
+      {
+        if (ch_table[i].pc != CHOOSER_EMPTY)
+        {
+          table[chooser_slot(table, capacity, ch_table[i].pc)] = ch_table[i];
+        }
+      }
+      free(ch_table);
+      ch_table = table;
+      ch_capacity = capacity;
+      slot = chooser_slot(ch_table, ch_capacity, pc);
+    }
+    memset(&ch_table[slot], 0, sizeof(struct chooser_entry));
+    ch_table[slot].pc = pc;
+    ch_used++;
+  }
+  return &ch_table[slot];
+}
+
+// Observe a branch before its tables are trained, using the same
+// indices as tournament_predict or custom_tournament_predict
+//
+void chooser_observe(uint32_t pc, uint32_t outcome)
+{
+  uint32_t pc_idx = pc & ((1 << pcIndexBits) - 1);
+  uint32_t local_pred, global_pred, choice_pred;
+  if (bpType == TOURNAMENT)
+  {
+    uint32_t global_idx = t_ghistory & ((1 << tghistoryBits) - 1);
+    uint32_t choice_index = (pc_idx ^ t_ghistory) & ((1 << tghistoryBits) - 1);
+    local_pred = predict_3_bit(t_local_prediction_table[t_bht_local[pc_idx] & ((1 << tlhistoryBits) - 1)]);
+    global_pred = predict_2_bit(t_global_prediction_table[global_idx]);
+    choice_pred = predict_2_bit(choice_predictor[choice_index]);
+  }
+  else if (bpType == CUSTOM && customType == CUSTOM_TOURNAMENT)
+  {
+    uint32_t choice_index = (pc_idx ^ c_ghistory) & ((1 << c_ghistoryBits) - 1);
+    local_pred = predict_3_bit(c_local_prediction_table[c_bht_local[pc_idx] & ((1 << clhistoryBits) - 1)]);
+    global_pred = custom_gshare_predict(pc);
+    choice_pred = predict_2_bit(c_choice_predictor[choice_index]);
+  }
+  else
+  {
+    return;
+  }
+
+  //the chooser picks local on taken
+  int choice = (choice_pred == TAKEN) ? CHOOSER_LOCAL : CHOOSER_GLOBAL;
+  int local_right = local_pred == outcome;
+  int global_right = global_pred == outcome;
+  int chosen_right = (choice == CHOOSER_LOCAL) ? local_right : global_right;
+  int other_right = (choice == CHOOSER_LOCAL) ? global_right : local_right;
+  if (scoredBranch)
+  {
+    ch_cells[choice][chosen_right][other_right]++;
+
+    struct chooser_entry *e = chooser_entry(pc);
+    e->executed++;
+    e->cells[choice][chosen_right][other_right]++;
+    if (ch_historyPc[pc_idx] != pc && ch_historyPc[pc_idx] != CHOOSER_EMPTY)
+    {
+      e->sharedHistory++;
+    }
+  }
+  ch_historyPc[pc_idx] = pc;
+}
+
+int chooser_compare(const void *a, const void *b)
+{
+  const struct chooser_entry *x = (const struct chooser_entry *)a;
+  const struct chooser_entry *y = (const struct chooser_entry *)b;
+  return (x->executed < y->executed) - (x->executed > y->executed);
+}
+
+void print_chooser_stats()
+{
+  const char *name[2] = {"local", "global"};
+  uint64_t total = 0, lost = 0, mispredicted = 0;
+  printf("Chooser:\n");
+  printf("  %-7s %12s %12s %12s %12s %12s\n", "Choice", "Picked", "Both Right", "Chosen Only", "Other Only", "Both Wrong");
+  for (int c = 0; c < 2; c++)
+  {
+    uint64_t picked = ch_cells[c][0][0] + ch_cells[c][0][1] + ch_cells[c][1][0] + ch_cells[c][1][1];
+    printf("  %-7s %12llu %12llu %12llu %12llu %12llu\n", name[c], (unsigned long long)picked,
+           (unsigned long long)ch_cells[c][1][1], (unsigned long long)ch_cells[c][1][0],
+           (unsigned long long)ch_cells[c][0][1], (unsigned long long)ch_cells[c][0][0]);
+    total += picked;
+    lost += ch_cells[c][0][1];
+    mispredicted += ch_cells[c][0][1] + ch_cells[c][0][0];
+  }
+  printf("  Lost to the chooser: %llu of %llu mispredictions (%.2f%%)\n", (unsigned long long)lost,
+         (unsigned long long)mispredicted, mispredicted ? 100 * ((float)lost / (float)mispredicted) : 0);
+
+  //hot branches, compacted in place and sorted by executions
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < ch_capacity; i++)
+  {
+    if (ch_table[i].pc != CHOOSER_EMPTY)
+    {
+      ch_table[n++] = ch_table[i];
+    }
+  }
+  qsort(ch_table, n, sizeof(struct chooser_entry), chooser_compare);
+  printf("  Hot branches (%u of %u):\n", n < (uint32_t)chooserTopN ? n : chooserTopN, n);
+  printf("  %-10s %12s %8s %10s %10s %10s %10s\n", "PC", "Executed", "Local%", "Wrong", "Lost", "Both Wrong", "Shared LH%");
+  for (uint32_t i = 0; i < n && i < (uint32_t)chooserTopN; i++)
+  {
+    struct chooser_entry *e = &ch_table[i];
+    uint64_t local = e->cells[CHOOSER_LOCAL][0][0] + e->cells[CHOOSER_LOCAL][0][1] +
+                     e->cells[CHOOSER_LOCAL][1][0] + e->cells[CHOOSER_LOCAL][1][1];
+    uint64_t both_wrong = e->cells[0][0][0] + e->cells[1][0][0];
+    uint64_t entry_lost = e->cells[0][0][1] + e->cells[1][0][1];
+    printf("  0x%08x %12llu %7.2f%% %10llu %10llu %10llu %9.2f%%\n", e->pc, (unsigned long long)e->executed,
+           100 * ((float)local / (float)e->executed), (unsigned long long)(both_wrong + entry_lost),
+           (unsigned long long)entry_lost, (unsigned long long)both_wrong,
+           100 * ((float)e->sharedHistory / (float)e->executed));
+  }
+  free(ch_table);
+  ch_table = NULL;
+}
+
+// overriding predictor functions
+uint64_t override_budget_bits()
+{
+  return ((uint64_t)2 << overrideHistoryBits) + overrideHistoryBits;
+}
+
+void init_override()
+{
+  uint32_t entries = 1 << overrideHistoryBits;
+  ov_bht = (uint8_t *)malloc(entries * sizeof(uint8_t));
+  memset(ov_bht, WN, entries * sizeof(uint8_t));
+  ov_ghistory = 0;
+  ov_fastCorrect = 0;
+  ov_slowCorrect = 0;
+  ov_overrides = 0;
+  ov_overridesCorrect = 0;
+  ov_branches = 0;
+}
+
+uint32_t ov_index(uint32_t pc)
+{
+  return (pc ^ ov_ghistory) & ((1 << overrideHistoryBits) - 1);
+}
+
+uint32_t override_predict(uint32_t pc)
+{
+  return predict_2_bit(ov_bht[ov_index(pc)]);
+}
+
+// Same update as train_gshare on the fast level's own table
+//
+void train_override_fast(uint32_t pc, uint32_t outcome)
+{
+  train_2b_counter(&ov_bht[ov_index(pc)], outcome);
+  ov_ghistory = (ov_ghistory << 1) | outcome;
+}
+
+// Score both levels of a resolved branch, the fast level is trained
+// with the others in train_immediate
+//
+void train_override(uint32_t pc, uint32_t outcome)
+{
+  if (scoredBranch)
+  {
+    ov_branches++;
+    if (ov_fastPred == outcome)
+      ov_fastCorrect++;
+    if (ov_slowPred == outcome)
+      ov_slowCorrect++;
+    if (ov_fastPred != ov_slowPred)
+    {
+      ov_overrides++;
+      if (ov_slowPred == outcome)
+        ov_overridesCorrect++;
+    }
+  }
+}
+
+void print_override_stats()
+{
+  uint64_t bubbles = ov_overrides * overrideLatency;
+  printf("Fast Correct:    %10llu\n", (unsigned long long)ov_fastCorrect);
+  printf("Slow Correct:    %10llu\n", (unsigned long long)ov_slowCorrect);
+  printf("Overrides:       %10llu\n", (unsigned long long)ov_overrides);
+  printf("Override Correct:%10llu\n", (unsigned long long)ov_overridesCorrect);
+  //every override squashes what the fast prediction fetched meanwhile
+  printf("Bubble Cycles:   %10llu\n", (unsigned long long)bubbles);
+  float rate = ov_branches ? 1000 * ((float)bubbles / (float)ov_branches) : 0;
+  printf("Bubbles per 1000 Branches: %7.3f\n", rate);
+}
+
+void cleanup_override()
+{
+  free(ov_bht);
+}
+
+// delayed update pipeline functions
+void history_save(struct history_checkpoint *cp, uint32_t pc)
+{
+  uint32_t pc_idx = pc & ((1 << pcIndexBits) - 1);
+  cp->ghistory = ghistory;
+  cp->ov_ghistory = ov_ghistory;
+  cp->t_ghistory = t_ghistory;
+  cp->c_ghistory = c_ghistory;
+  cp->y_ghistory = y_ghistory;
+  cp->gs_ghistory = gs_ghistory;
+  cp->bm_ghistory = bm_ghistory;
+  cp->hp_ghistory = hp_ghistory;
+  cp->hp_phistory = hp_phistory;
+  cp->sc_ghistory = sc_ghistory;
+  cp->t_local = t_bht_local ? t_bht_local[pc_idx] : 0;
+  cp->c_local = c_bht_local ? c_bht_local[pc_idx] : 0;
+  cp->hp_local = hp_bht_local ? hp_bht_local[pc_idx] : 0;
+  struct loop_entry *l = loopEnabled ? loop_lookup(pc) : NULL;
+  cp->l_tag = l ? l->tag : 0;
+  cp->l_specIter = l ? l->specIter : 0;
+  if (p_ghistory)
+  {
+    memcpy(cp->p_ghistory, p_ghistory, perceptronHistoryBits + 1);
+  }
+}
+
+void history_restore(const struct history_checkpoint *cp, uint32_t pc)
+{
+  uint32_t pc_idx = pc & ((1 << pcIndexBits) - 1);
+  ghistory = cp->ghistory;
+  ov_ghistory = cp->ov_ghistory;
+  t_ghistory = cp->t_ghistory;
+  c_ghistory = cp->c_ghistory;
+  y_ghistory = cp->y_ghistory;
+  gs_ghistory = cp->gs_ghistory;
+  bm_ghistory = cp->bm_ghistory;
+  hp_ghistory = cp->hp_ghistory;
+  hp_phistory = cp->hp_phistory;
+  sc_ghistory = cp->sc_ghistory;
+  if (t_bht_local)
+    t_bht_local[pc_idx] = cp->t_local;
+  if (c_bht_local)
+    c_bht_local[pc_idx] = cp->c_local;
+  if (hp_bht_local)
+    hp_bht_local[pc_idx] = cp->hp_local;
+  //the entry may have been replaced since, then there is nothing to repair
+  struct loop_entry *l = cp->l_tag ? loop_lookup(pc) : NULL;
+  if (l != NULL)
+    l->specIter = cp->l_specIter;
+  if (p_ghistory)
+  {
+    memcpy(p_ghistory, cp->p_ghistory, perceptronHistoryBits + 1);
+  }
+  //rows cached at prediction time belong to a different history now
+  hp_lastValid = 0;
+}
+
+// Shift 'outcome' into every history the active predictors keep,
+// exactly as the history updates at the end of their train functions do
+//
+void speculate_history(uint32_t pc, uint32_t outcome)
+{
+  uint32_t pc_idx = pc & ((1 << pcIndexBits) - 1);
+  switch (bpType)
+  {
+  case GSHARE:
+    ghistory = ((ghistory << 1) | outcome);
+    break;
+  case TOURNAMENT:
+    t_bht_local[pc_idx] = ((t_bht_local[pc_idx] << 1) | outcome) & ((1 << tlhistoryBits) - 1);
+    t_ghistory = ((t_ghistory << 1) | outcome) & ((1 << tghistoryBits) - 1);
+    break;
+  case YAGS:
+    y_ghistory = ((y_ghistory << 1) | outcome) & ((1ull << yagsHistoryBits) - 1);
+    break;
+  case CUSTOM:
+    switch (customType)
+    {
+    case CUSTOM_PERCEPTRON:
+      memmove(&p_ghistory[2], &p_ghistory[1], perceptronHistoryBits - 1);
+      p_ghistory[1] = (outcome == TAKEN) ? 1 : -1;
+      break;
+    case CUSTOM_HASHED:
+      hp_bht_local[pc_idx] = (hp_bht_local[pc_idx] << 1) | outcome;
+      hp_ghistory = (hp_ghistory << 1) | outcome;
+      hp_phistory = (hp_phistory << 2) | ((pc >> 2) & 3);
+      break;
+    case CUSTOM_GSKEW:
+      gs_ghistory = ((gs_ghistory << 1) | outcome) & ((1ull << gskewHistoryBits) - 1);
+      break;
+    case CUSTOM_BIMODE:
+      bm_ghistory = ((bm_ghistory << 1) | outcome) & ((1ull << bimodeHistoryBits) - 1);
+      break;
+    default:
+      //train_custom_gshare and train_custom_tournament both shift c_ghistory
+      c_ghistory = ((c_ghistory << 1) | outcome);
+      c_bht_local[pc_idx] = ((c_bht_local[pc_idx] << 1) | outcome) & ((1 << clhistoryBits) - 1);
+      c_ghistory = ((c_ghistory << 1) | outcome) & ((1 << c_ghistoryBits) - 1);
+      break;
+    }
+    break;
+  default:
+    break;
+  }
+  if (scEnabled)
+  {
+    sc_ghistory = (sc_ghistory << 1) | outcome;
+  }
+  if (loopEnabled)
+  {
+    loop_speculate(pc, outcome);
+  }
+  if (overrideEnabled)
+  {
+    ov_ghistory = (ov_ghistory << 1) | outcome;
+  }
+}
+
+void init_pipeline()
+{
+  pl_fifo = (struct pipeline_entry *)malloc((updateDelay + 1) * sizeof(struct pipeline_entry));
+  pl_head = 0;
+  pl_count = 0;
+  pl_recoveries = 0;
+}
+
+// Checkpoint the histories and update them with the prediction, the
+// branch stays in flight until train_predictor resolves it
+//
+void pipeline_fetch(uint32_t pc, uint32_t prediction)
+{
+  struct pipeline_entry *e = &pl_fifo[(pl_head + pl_count) % (updateDelay + 1)];
+  e->pc = pc;
+  e->prediction = prediction;
+  e->scored = scoredBranch;
+  history_save(&e->checkpoint, pc);
+  speculate_history(pc, prediction);
+}
+
+// Train the tables with the histories the branch saw when it was
+// predicted, leaving the current speculative histories untouched
+//
+void pipeline_retire()
+{
+  struct pipeline_entry *e = &pl_fifo[pl_head];
+  struct history_checkpoint now;
+  int scored = scoredBranch;
+  history_save(&now, e->pc);
+  history_restore(&e->checkpoint, e->pc);
+  scoredBranch = e->scored;
+  train_immediate(e->pc, e->outcome);
+  scoredBranch = scored;
+  history_restore(&now, e->pc);
+  pl_head = (pl_head + 1) % (updateDelay + 1);
+  pl_count--;
+}
+
+void pipeline_resolve(uint32_t pc, uint32_t outcome)
+{
+  struct pipeline_entry *e = &pl_fifo[(pl_head + pl_count) % (updateDelay + 1)];
+  if (e->prediction != outcome)
+  {
+    //younger branches would be on the wrong path, which the trace never
+    //contains, so recovery only has to repair this branch's histories
+    pl_recoveries += scoredBranch;
+    history_restore(&e->checkpoint, pc);
+    speculate_history(pc, outcome);
+  }
+  e->outcome = outcome;
+  pl_count++;
+  if (pl_count > updateDelay)
+  {
+    pipeline_retire();
+  }
+}
+
+void print_pipeline_stats()
+{
+  printf("Update Delay:    %10d\n", updateDelay);
+  printf("Recoveries:      %10llu\n", (unsigned long long)pl_recoveries);
+}
+
+void cleanup_pipeline()
+{
+  free(pl_fifo);
+}
+
+// checkpoint functions
+//
+// Every piece of predictor state as a list of memory regions, so saving
+// and loading is a walk over the same list
+//
+int state_regions(struct state_region *regions, int max)
+{
+  int n = 0;
+#define REGION(ptr, size)             \
+  do                                  \
+  {                                   \
+    if (n < max)                      \
+    {                                 \
+      regions[n].name = #ptr;         \
+      regions[n].data = (void *)(ptr); \
+      regions[n].bytes = (size);      \
+      n++;                            \
+    }                                 \
+  } while (0)
+  if (bpType == GSHARE)
+  {
+    REGION(bht_gshare, (size_t)1 << ghistoryBits);
+    REGION(&ghistory, sizeof(ghistory));
+  }
+  switch (bpType)
+  {
+  case TOURNAMENT:
+    REGION(t_global_prediction_table, (size_t)1 << tghistoryBits);
+    REGION(&t_ghistory, sizeof(t_ghistory));
+    REGION(t_bht_local, sizeof(uint16_t) << pcIndexBits);
+    REGION(t_local_prediction_table, (size_t)1 << tlhistoryBits);
+    REGION(choice_predictor, (size_t)1 << tghistoryBits);
+    break;
+  case YAGS:
+    REGION(y_choice, (size_t)1 << yagsChoiceBits);
+    for (int d = 0; d < 2; d++)
+    {
+      REGION(y_cache_tag[d], sizeof(uint16_t) << yagsCacheBits);
+      REGION(y_cache_ctr[d], (size_t)1 << yagsCacheBits);
+    }
+    REGION(&y_ghistory, sizeof(y_ghistory));
+    break;
+  case CUSTOM:
+    switch (customType)
+    {
+    case CUSTOM_TOURNAMENT:
+      REGION(c_bht_gshare, (size_t)1 << c_ghistoryBits);
+      REGION(&c_ghistory, sizeof(c_ghistory));
+      REGION(c_bht_local, sizeof(uint16_t) << pcIndexBits);
+      REGION(c_local_prediction_table, (size_t)1 << clhistoryBits);
+      REGION(c_choice_predictor, (size_t)1 << c_ghistoryBits);
+      break;
+    case CUSTOM_PERCEPTRON:
+      REGION(p_weights, (size_t)p_rowLength << perceptronIndexBits);
+      REGION(p_ghistory, (size_t)p_rowLength);
+      break;
+    case CUSTOM_HASHED:
+      REGION(hp_weights, (size_t)hp_numFeatures << hpTableBits);
+      REGION(hp_bht_local, sizeof(uint16_t) << pcIndexBits);
+      REGION(&hp_ghistory, sizeof(hp_ghistory));
+      REGION(&hp_phistory, sizeof(hp_phistory));
+      REGION(&hp_theta, sizeof(hp_theta));
+      REGION(&hp_thetaCounter, sizeof(hp_thetaCounter));
+      break;
+    case CUSTOM_GSKEW:
+      for (int b = 0; b < GSKEW_BANKS; b++)
+      {
+        REGION(gs_banks[b], packed_2b_bits(1 << gskewBankBits) / 8);
+      }
+      REGION(&gs_ghistory, sizeof(gs_ghistory));
+      break;
+    case CUSTOM_BIMODE:
+      REGION(bm_choice, packed_2b_bits(1 << bimodeChoiceBits) / 8);
+      REGION(bm_direction[NOTTAKEN], packed_2b_bits(1 << bimodeDirBits) / 8);
+      REGION(bm_direction[TAKEN], packed_2b_bits(1 << bimodeDirBits) / 8);
+      REGION(&bm_ghistory, sizeof(bm_ghistory));
+      break;
+    }
+    break;
+  default:
+    break;
+  }
+  if (scEnabled)
+  {
+    REGION(sc_tables, (size_t)SC_TABLES << scTableBits);
+    REGION(sc_conf, (size_t)1 << scTableBits);
+    REGION(&sc_ghistory, sizeof(sc_ghistory));
+    REGION(&sc_theta, sizeof(sc_theta));
+    REGION(&sc_thetaCounter, sizeof(sc_thetaCounter));
+  }
+  if (loopEnabled)
+  {
+    REGION(l_table, (sizeof(struct loop_entry) * LOOP_WAYS) << loopIndexBits);
+  }
+  if (overrideEnabled)
+  {
+    REGION(ov_bht, (size_t)1 << overrideHistoryBits);
+    REGION(&ov_ghistory, sizeof(ov_ghistory));
+  }
+#undef REGION
+  return n + target_state_regions(regions + n, max - n);
+}
+
+// The header identifies the predictor and its configuration, a
+// checkpoint only loads into the same setup it was saved from
+//
+struct checkpoint_header
+{
+  char magic[4];
+  int32_t bpType;
+  int32_t customType;
+  int32_t scEnabled;
+  int32_t loopEnabled;
+  int32_t overrideEnabled;
+  int32_t ittageEnabled;
+  int32_t rasEnabled;
+  int32_t btbEnabled;
+  struct hp_feature hpFeatures[HP_MAX_FEATURES]; //hashed perceptron only, zero otherwise
+  int32_t numParams;
+  int32_t numRegions;
+  uint64_t branches; //conditional branches trained before the save
+};
+
+void save_checkpoint(const char *path, uint64_t branches)
+{
+  if (updateDelay)
+  {
+    fprintf(stderr, "Checkpoints do not hold branches in flight, use them without --delay\n");
+    exit(1);
+  }
+  struct predictor_param params[MAX_PREDICTOR_PARAMS];
+  struct state_region regions[MAX_STATE_REGIONS];
+  struct checkpoint_header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, CHECKPOINT_MAGIC, 4);
+  h.bpType = bpType;
+  h.customType = customType;
+  h.scEnabled = scEnabled;
+  h.loopEnabled = loopEnabled;
+  h.overrideEnabled = overrideEnabled;
+  h.ittageEnabled = ittageEnabled;
+  h.rasEnabled = rasEnabled;
+  h.btbEnabled = btbEnabled;
+  if (bpType == CUSTOM && customType == CUSTOM_HASHED)
+  {
+    memcpy(h.hpFeatures, hp_features, hp_numFeatures * sizeof(struct hp_feature));
+  }
+  h.numParams = predictor_params(params, MAX_PREDICTOR_PARAMS);
+  h.numRegions = state_regions(regions, MAX_STATE_REGIONS);
+  h.branches = branches;
+
+  FILE *file = fopen(path, "wb");
+  int ok = file != NULL && fwrite(&h, sizeof(h), 1, file) == 1;
+  for (int i = 0; ok && i < h.numParams; i++)
+  {
+    int32_t value = params[i].value;
+    ok = fwrite(&value, sizeof(value), 1, file) == 1;
+  }
+  for (int i = 0; ok && i < h.numRegions; i++)
+  {
+    uint64_t bytes = regions[i].bytes;
+    ok = fwrite(&bytes, sizeof(bytes), 1, file) == 1 &&
+         fwrite(regions[i].data, 1, regions[i].bytes, file) == regions[i].bytes;
+  }
+  if (!ok || fclose(file))
+  {
+    fprintf(stderr, "Cannot write checkpoint %s\n", path);
+    exit(1);
+  }
+}
+
+uint64_t load_checkpoint(const char *path)
+{
+  struct predictor_param params[MAX_PREDICTOR_PARAMS];
+  struct state_region regions[MAX_STATE_REGIONS];
+  struct checkpoint_header h;
+  FILE *file = fopen(path, "rb");
+  if (file == NULL || fread(&h, sizeof(h), 1, file) != 1 || memcmp(h.magic, CHECKPOINT_MAGIC, 4))
+  {
+    fprintf(stderr, "Cannot read checkpoint %s\n", path);
+    exit(1);
+  }
+  int numParams = predictor_params(params, MAX_PREDICTOR_PARAMS);
+  int numRegions = state_regions(regions, MAX_STATE_REGIONS);
+  if (h.bpType != bpType || (bpType == CUSTOM && h.customType != customType) ||
+      h.scEnabled != scEnabled || h.loopEnabled != loopEnabled || h.overrideEnabled != overrideEnabled ||
+      h.ittageEnabled != ittageEnabled || h.rasEnabled != rasEnabled || h.btbEnabled != btbEnabled ||
+      h.numParams != numParams || h.numRegions != numRegions)
+  {
+    fprintf(stderr, "Checkpoint %s was saved from a different predictor setup\n", path);
+    exit(1);
+  }
+  //the feature list is configuration, it must match rather than be loaded
+  if (bpType == CUSTOM && customType == CUSTOM_HASHED &&
+      memcmp(h.hpFeatures, hp_features, hp_numFeatures * sizeof(struct hp_feature)))
+  {
+    fprintf(stderr, "Checkpoint %s was saved with different hashed perceptron features\n", path);
+    exit(1);
+  }
+  for (int i = 0; i < numParams; i++)
+  {
+    int32_t value;
+    if (fread(&value, sizeof(value), 1, file) != 1 || value != params[i].value)
+    {
+      fprintf(stderr, "Checkpoint %s was saved with a different %s\n", path, params[i].name);
+      exit(1);
+    }
+  }
+  for (int i = 0; i < numRegions; i++)
+  {
+    uint64_t bytes;
+    if (fread(&bytes, sizeof(bytes), 1, file) != 1 || bytes != regions[i].bytes ||
+        fread(regions[i].data, 1, regions[i].bytes, file) != regions[i].bytes)
+    {
+      fprintf(stderr, "Checkpoint %s does not match %s\n", path, regions[i].name);
+      exit(1);
+    }
+  }
+  fclose(file);
+  return h.branches;
+}
+
+// custom slot, dispatches to the predictor selected by customType
+void init_custom()
+{
+  switch (customType)
+  {
+  case CUSTOM_PERCEPTRON:
+    init_perceptron();
+    break;
+  case CUSTOM_HASHED:
+    init_hashed_perceptron();
+    break;
+  case CUSTOM_GSKEW:
+    init_gskew();
+    break;
+  case CUSTOM_BIMODE:
+    init_bimode();
+    break;
+  default:
+    init_custom_tournament();
+    break;
+  }
+}
+
+uint32_t custom_predict(uint32_t pc)
+{
+  switch (customType)
+  {
+  case CUSTOM_PERCEPTRON:
+    return perceptron_predict(pc);
+  case CUSTOM_HASHED:
+    return hashed_perceptron_predict(pc);
+  case CUSTOM_GSKEW:
+    return gskew_predict(pc);
+  case CUSTOM_BIMODE:
+    return bimode_predict(pc);
+  default:
+    return custom_tournament_predict(pc);
+  }
+}
+
+void train_custom(uint32_t pc, uint32_t outcome)
+{
+  switch (customType)
+  {
+  case CUSTOM_PERCEPTRON:
+    return train_perceptron(pc, outcome);
+  case CUSTOM_HASHED:
+    return train_hashed_perceptron(pc, outcome);
+  case CUSTOM_GSKEW:
+    return train_gskew(pc, outcome);
+  case CUSTOM_BIMODE:
+    return train_bimode(pc, outcome);
+  default:
+    return train_custom_tournament(pc, outcome);
+  }
+}
+
+void cleanup_tournament(){
+  free(t_bht_local);
+  t_bht_local = NULL;
+  free(t_local_prediction_table);
+  free(t_global_prediction_table);
+  free(choice_predictor);
+}
+
+void cleanup_gshare()
+{
+  free(bht_gshare);
+}
+
+void cleanup_custom_tournament(){
+  free(c_bht_local);
+  c_bht_local = NULL;
+  free(c_local_prediction_table);
+  free(c_choice_predictor);
+  free(c_bht_gshare);
+}
+
+void cleanup_custom()
+{
+  switch (customType)
+  {
+  case CUSTOM_PERCEPTRON:
+    cleanup_perceptron();
+    break;
+  case CUSTOM_HASHED:
+    cleanup_hashed_perceptron();
+    break;
+  case CUSTOM_GSKEW:
+    cleanup_gskew();
+    break;
+  case CUSTOM_BIMODE:
+    cleanup_bimode();
+    break;
+  default:
+    cleanup_custom_tournament();
+    break;
+  }
+}
+
+void init_predictor()
+{
+  switch (bpType)
+  {
+  case STATIC:
+    break;
+  case GSHARE:
+    init_gshare();
+    break;
+  case TOURNAMENT:
+    init_tournament();
+    break;
+  case CUSTOM:
+    init_custom();
+    break;
+  case YAGS:
+    init_yags();
+    break;
+  default:
+    break;
+  }
+
+  if (scEnabled)
+  {
+    init_sc();
+  }
+  if (loopEnabled)
+  {
+    init_loop();
+  }
+  if (updateDelay)
+  {
+    init_pipeline();
+  }
+  if (overrideEnabled)
+  {
+    init_override();
+  }
+  if (aliasStats)
+  {
+    init_alias();
+  }
+  if (chooserStats)
+  {
+    init_chooser();
+  }
+}
+
+// Make a prediction for conditional branch instruction at PC 'pc'
+// Returning TAKEN indicates a prediction of taken; returning NOTTAKEN
+// indicates a prediction of not taken
+//
+uint32_t make_prediction(uint32_t pc, uint32_t target, uint32_t direct)
+{
+  uint32_t prediction = base_prediction(pc);
+  if (scEnabled)
+  {
+    prediction = sc_predict(pc, prediction);
+  }
+  if (loopEnabled)
+  {
+    prediction = loop_predict(pc, prediction);
+  }
+  if (overrideEnabled)
+  {
+    ov_fastPred = override_predict(pc);
+    ov_slowPred = prediction;
+  }
+  if (updateDelay)
+  {
+    pipeline_fetch(pc, prediction);
+  }
+  return prediction;
+}
+
+// Prediction of the predictor selected by bpType alone
+//
+uint32_t base_prediction(uint32_t pc)
+{
+  switch (bpType)
+  {
+  case STATIC:
+    return TAKEN;
+  case GSHARE:
+    return gshare_predict(pc);
+  case TOURNAMENT:
+    return tournament_predict(pc);
+  case CUSTOM:
+    return custom_predict(pc);
+  case YAGS:
+    return yags_predict(pc);
+  default:
+    break;
+  }
+
+  // If there is not a compatable bpType then return NOTTAKEN
+  return NOTTAKEN;
+}
+
+// Train the predictor the last executed branch at PC 'pc' and with
+// outcome 'outcome' (true indicates that the branch was taken, false
+// indicates that the branch was not taken)
+//
+
+void train_predictor(uint32_t pc, uint32_t target, uint32_t outcome, uint32_t condition, uint32_t call, uint32_t ret, uint32_t direct)
+{
+  if (condition)
+  {
+    if (updateDelay)
+    {
+      pipeline_resolve(pc, outcome);
+    }
+    else
+    {
+      train_immediate(pc, outcome);
+    }
+    if (overrideEnabled)
+    {
+      train_override(pc, outcome);
+    }
+  }
+}
+
+// Train every component on a conditional branch right away
+//
+void train_immediate(uint32_t pc, uint32_t outcome)
+{
+  if (scEnabled || loopEnabled)
+  {
+    //side components need the predictions from before any training
+    uint32_t prediction = base_prediction(pc);
+    uint32_t corrected = scEnabled ? sc_predict(pc, prediction) : prediction;
+    if (scEnabled)
+    {
+      train_sc(pc, outcome, prediction);
+    }
+    if (loopEnabled)
+    {
+      train_loop(pc, outcome, corrected);
+    }
+  }
+  train_base(pc, outcome);
+  if (overrideEnabled)
+  {
+    train_override_fast(pc, outcome);
+  }
+}
+
+// Train the predictor selected by bpType alone
+//
+void train_base(uint32_t pc, uint32_t outcome)
+{
+  if (aliasStats)
+  {
+    alias_observe(pc, outcome);
+  }
+  if (chooserStats)
+  {
+    chooser_observe(pc, outcome);
+  }
+  switch (bpType)
+  {
+  case STATIC:
+    return;
+  case GSHARE:
+    return train_gshare(pc, outcome);
+  case TOURNAMENT:
+    return train_tournament(pc, outcome);
+  case CUSTOM:
+    return train_custom(pc, outcome);
+  case YAGS:
+    return train_yags(pc, outcome);
+  default:
+    break;
+  }
 }
 
 void train_2b_counter(uint8_t *counter, uint8_t outcome){
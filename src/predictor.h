@@ -72,7 +72,33 @@ uint32_t make_prediction(uint32_t pc, uint32_t target, uint32_t direct);
 void train_predictor(uint32_t pc, uint32_t target, uint32_t outcome, uint32_t condition, uint32_t call, uint32_t ret, uint32_t direct);
 
 // Please add your code below, and DO NOT MODIFY ANY OF THE CODE ABOVE
+
+// Predictor types added after the original four
+#define YAGS 4
+
+// Hardware budget: 64Kbits of tables plus 1024 bits for registers
+#define BUDGET_BITS ((64 * 1024) + 1024)
+
+// Prediction and training of the bpType predictor on its own, without
+// any of the optional side components in front of it
+uint32_t base_prediction(uint32_t pc);
+void train_base(uint32_t pc, uint32_t outcome);
+
+// Train the bpType predictor and its side components on a conditional
+// branch now, bypassing any update delay
+void train_immediate(uint32_t pc, uint32_t outcome);
+
+// gshare
+void init_gshare();
+uint8_t gshare_predict(uint32_t pc);
+void train_gshare(uint32_t pc, uint8_t outcome);
+void cleanup_gshare();
+
 // tournament
+void init_tournament();
+uint32_t tournament_predict(uint32_t pc);
+void train_tournament(uint32_t pc, uint32_t outcome);
+void cleanup_tournament();
 void saturating_add(uint8_t *counter, uint8_t max);
 void saturating_sub(uint8_t *counter, uint8_t min);
 void train_2b_counter(uint8_t *counter, uint8_t outcome);
@@ -80,10 +106,150 @@ void train_3b_counter(uint8_t *counter, uint8_t outcome);
 uint32_t predict_2_bit(uint8_t counter);
 uint32_t predict_3_bit(uint8_t counter);
 
+// packed tables of 2-bit counters, four per byte
+uint8_t *alloc_packed_2b(uint32_t entries, uint8_t init);
+uint8_t packed_2b_get(const uint8_t *table, uint32_t idx);
+void packed_2b_train(uint8_t *table, uint32_t idx, uint32_t outcome);
+uint64_t packed_2b_bits(uint32_t entries);
+
+// budget
+// Warns on stderr when 'bits' exceeds BUDGET_BITS. Only a warning, so
+// sweeps can still measure configurations past the budget
+void check_budget(const char *name, uint64_t bits);
+// Bits of tables and history of the selected predictor and the
+// corrector, loop and override tables in use
+uint64_t predictor_budget_bits();
+
+// configuration knobs of the selected predictor, for reports
+struct predictor_param
+{
+  const char *name;
+  int value;
+};
+#define MAX_PREDICTOR_PARAMS 24
+int predictor_params(struct predictor_param *params, int max);
+
+// checkpoints of the predictor state
+struct state_region
+{
+  const char *name;
+  void *data;
+  size_t bytes;
+};
+#define MAX_STATE_REGIONS 32
+#define CHECKPOINT_MAGIC "BPS1"
+int state_regions(struct state_region *regions, int max);
+// Write all tables and histories after 'branches' conditional branches
+void save_checkpoint(const char *path, uint64_t branches);
+// Restore them into the initialized predictor, returns the branch count
+// recorded by the save. Exits when the setup differs from the saved one
+uint64_t load_checkpoint(const char *path);
+
+//yags
+extern int yagsHistoryBits; //global history length for yags
+extern int yagsChoiceBits;  //log2 of the bimodal choice table entries
+extern int yagsCacheBits;   //log2 of the entries in each direction cache
+extern int yagsTagBits;     //tag width of the direction caches
+uint64_t yags_budget_bits();
+void init_yags();
+uint32_t yags_predict(uint32_t pc);
+void train_yags(uint32_t pc, uint32_t outcome);
+
+//statistical corrector, optional stage behind any bpType
+extern int scEnabled;     //invert the base prediction when the corrector disagrees
+extern int scTableBits;   //log2 of the entries in each corrector table
+uint64_t sc_budget_bits();
+void init_sc();
+uint32_t sc_predict(uint32_t pc, uint32_t base_pred);
+void train_sc(uint32_t pc, uint32_t outcome, uint32_t base_pred);
+void print_sc_stats();
+
+//loop predictor, optional side component in front of any bpType
+extern int loopEnabled;   //override with the loop predictor when confident
+extern int loopIndexBits; //log2 of the number of 4-way sets
+extern int loopTagBits;   //tag width
+uint64_t loop_budget_bits();
+void init_loop();
+uint32_t loop_predict(uint32_t pc, uint32_t base_pred);
+void train_loop(uint32_t pc, uint32_t outcome, uint32_t base_pred);
+void print_loop_stats();
+
+//side statistics only count branches past --warmup
+extern int scoredBranch;  //the branch being predicted or trained is scored
+
+//aliasing statistics for the gshare and tournament tables
+extern int aliasStats;    //track the last branch to touch each table entry
+void init_alias();
+void print_alias_stats();
+
+//chooser statistics for the tournament and custom tournament predictors
+extern int chooserStats;  //count the chooser's picks against both components
+extern int chooserTopN;   //hot branches in the report
+void init_chooser();
+void print_chooser_stats();
+
+//overriding predictor, gshare as a fast first level
+extern int overrideEnabled; //gshare predicts first, the bpType predictor overrides
+extern int overrideLatency; //cycles until the overriding prediction is ready
+extern int overrideHistoryBits; //global history length of the fast gshare
+uint64_t override_budget_bits();
+void init_override();
+void train_override(uint32_t pc, uint32_t outcome);
+void print_override_stats();
+
+//delayed update pipeline
+extern int updateDelay;   //branches in flight before tables are trained, 0 trains at once
+void init_pipeline();
+void pipeline_fetch(uint32_t pc, uint32_t prediction);
+void pipeline_resolve(uint32_t pc, uint32_t outcome);
+void print_pipeline_stats();
+
 //custom
+// The different predictors that can fill the custom slot
+#define CUSTOM_TOURNAMENT 0
+#define CUSTOM_PERCEPTRON 1
+#define CUSTOM_HASHED 2
+#define CUSTOM_GSKEW 3
+#define CUSTOM_BIMODE 4
+extern const char *customName[];
+extern int customType;   // Predictor used when bpType == CUSTOM
+
 void init_custom();
 uint32_t custom_predict(uint32_t pc);
 void train_custom(uint32_t pc, uint32_t outcome);
+void cleanup_custom();
+
+//perceptron
+extern int perceptronHistoryBits; //global history length for perceptron
+extern int perceptronIndexBits;   //log2 of the number of perceptron rows
+void init_perceptron();
+uint32_t perceptron_predict(uint32_t pc);
+void train_perceptron(uint32_t pc, uint32_t outcome);
+
+//hashed perceptron
+extern int hpTableBits; //log2 of the entries in each feature table
+int hp_parse_features(const char *spec);
+uint64_t hp_budget_bits();
+void init_hashed_perceptron();
+uint32_t hashed_perceptron_predict(uint32_t pc);
+void train_hashed_perceptron(uint32_t pc, uint32_t outcome);
+
+//2bc-gskew
+extern int gskewBankBits;    //log2 of the entries in each bank
+extern int gskewHistoryBits; //global history length
+uint64_t gskew_budget_bits();
+void init_gskew();
+uint32_t gskew_predict(uint32_t pc);
+void train_gskew(uint32_t pc, uint32_t outcome);
+
+//bi-mode
+extern int bimodeChoiceBits;  //log2 of the choice table entries
+extern int bimodeDirBits;     //log2 of the entries in each direction table
+extern int bimodeHistoryBits; //global history length
+uint64_t bimode_budget_bits();
+void init_bimode();
+uint32_t bimode_predict(uint32_t pc);
+void train_bimode(uint32_t pc, uint32_t outcome);
 
 
 
@@ -0,0 +1,107 @@
+#!/usr/bin/env bash
+#
+# Golden result regression check. Every predictor configuration runs on
+# a window of each bundled trace and on synthetic traces, and its per
+# branch prediction stream is compared with the one stored in golden/.
+#
+#   ./regress.sh            check against golden/
+#   ./regress.sh --update   re-record golden/ after an intended change
+#
+# Run from src/ after make.
+
+set -u
+
+RECORDS=1000000
+GOLDEN=golden
+UPDATE=0
+if [ "${1:-}" = "--update" ]; then
+  UPDATE=1
+fi
+
+CONFIGS=(
+  "static:--static"
+  "gshare:--gshare"
+  "tournament:--tournament"
+  "custom:--custom"
+  "perceptron:--custom:perceptron"
+  "hashed:--custom:hashed"
+  "gskew:--custom:gskew"
+  "bimode:--custom:bimode"
+  "yags:--yags"
+  "delay:--custom --delay:8"
+  "sc:--tournament --sc"
+  "loop:--tournament --loop"
+  "override:--tournament --override"
+  "delay_sc_loop:--custom --sc --loop --delay:8"
+  "yags_override_delay:--yags --override --delay:8"
+  # the stream only holds directions, this checks they stay untouched
+  "targets:--gshare --ittage --ras --btb"
+)
+
+# Records skipped before each trace window. The first millions of records
+# of every bundled trace run only a handful of hot branches, these windows
+# each exercise several hundred static conditional branches.
+trace_skip() {
+  case $1 in
+  U1_Blender) echo 3000000 ;;
+  U2_Leela) echo 3000000 ;;
+  U4_Cam4) echo 4000000 ;;
+  *) echo 0 ;;
+  esac
+}
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# Trace windows and synthetic traces, both fixed by construction
+TRACES=()
+for t in ../traces/*.bz2; do
+  name=$(basename "$t" .bz2)
+  bunzip2 -c "$t" | tail -n +$(($(trace_skip "$name") + 1)) | head -n $RECORDS > "$WORK/$name"
+  TRACES+=("$name")
+done
+./tracegen --records:$RECORDS --seed:1 --out:"$WORK/synth_mixed"
+./tracegen --records:$RECORDS --seed:2 --static:8192 --mix:10:40:40:5:5 --binary --out:"$WORK/synth_correlated"
+TRACES+=(synth_mixed synth_correlated)
+
+mkdir -p $GOLDEN
+failed=0
+for t in "${TRACES[@]}"; do
+  for c in "${CONFIGS[@]}"; do
+    name=${c%%:*}
+    args=${c#*:}
+    golden=$GOLDEN/$t.$name.bz2
+    if [ $UPDATE = 1 ]; then
+      if ./predictor $args --dump:"$WORK/stream" "$WORK/$t" > /dev/null &&
+        bzip2 -c "$WORK/stream" > "$golden"; then
+        echo "recorded $golden"
+      else
+        echo "FAIL    $t $name (not recorded)"
+        failed=$((failed + 1))
+      fi
+      continue
+    fi
+    if [ ! -f "$golden" ]; then
+      echo "MISSING $t $name (run ./regress.sh --update)"
+      failed=$((failed + 1))
+      continue
+    fi
+    bunzip2 -c "$golden" > "$WORK/golden"
+    if ./predictor $args --golden-check:"$WORK/golden" "$WORK/$t" > "$WORK/out"; then
+      echo "ok      $t $name"
+    else
+      echo "FAIL    $t $name"
+      sed -n '/^Golden Check/,$p' "$WORK/out"
+      failed=$((failed + 1))
+    fi
+  done
+done
+
+if [ $failed -ne 0 ]; then
+  if [ $UPDATE = 1 ]; then
+    echo "$failed golden recording(s) failed"
+  else
+    echo "$failed regression check(s) failed"
+  fi
+  exit 1
+fi
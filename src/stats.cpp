@@ -0,0 +1,1030 @@
+//========================================================//
+//  stats.cpp                                             //
+//  Source file for the Simulator Statistics              //
+//                                                        //
+//  Collected in main alongside the predictor and         //
+//  printed after the summary                             //
+//========================================================//
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/resource.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "predictor.h"
+#include "stats.h"
+
+//------------------------------------//
+//        Statistics Configuration    //
+//------------------------------------//
+int profileMode = PROFILE_OFF;
+int profileTopN = 20;
+uint64_t numInstructions = 0;
+uint64_t warmupBranches = 0;
+int numRegions = 0;
+uint64_t intervalLength = 0;
+const char *intervalPath = NULL;
+const char *dumpPath = NULL;
+const char *goldenCheckPath = NULL;
+int jsonEnabled = 0;
+const char *jsonPath = NULL;
+int statsEnabled = 0;
+int perfEnabled = 0;
+
+//------------------------------------//
+//     Statistics Data Structures     //
+//------------------------------------//
+
+//profile
+struct profile_entry
+{
+  uint32_t pc;
+  uint64_t executed;
+  uint64_t taken;
+  uint64_t mispredicted;
+};
+
+//exact profile, linear probing table that doubles at half load
+#define PROFILE_INIT_BITS 12
+#define PROFILE_EMPTY 0xffffffff //pc marking an unused slot
+struct profile_entry *pr_table;
+uint32_t pr_capacity;
+uint32_t pr_used;
+
+//sketch profile, count-min rows for each counter plus a small set of
+//candidates holding the branches with the most estimated mispredictions
+#define SKETCH_ROWS 4
+#define SKETCH_BITS 16
+uint32_t *sk_executed[SKETCH_ROWS];
+uint32_t *sk_taken[SKETCH_ROWS];
+uint32_t *sk_mispredicted[SKETCH_ROWS];
+struct profile_entry *sk_candidates;
+uint32_t sk_numCandidates;
+
+//interval
+// Rows are formatted into a private buffer and written in large blocks
+#define INTERVAL_BUFFER_SIZE (1 << 16)
+#define INTERVAL_ROW_MAX 128
+FILE *iv_file;
+char *iv_buffer;
+size_t iv_used;
+uint64_t iv_index;         //rows written so far
+uint64_t iv_total;         //branches before the current interval
+uint64_t iv_branches;      //branches in the current interval
+uint64_t iv_taken;
+uint64_t iv_mispredicted;
+// Rows kept for the JSON results
+struct interval_record
+{
+  uint64_t first;
+  uint64_t branches;
+  uint64_t taken;
+  uint64_t mispredicted;
+};
+struct interval_record *iv_records;
+uint64_t iv_recordCapacity;
+
+//json
+char *js_buffer;
+size_t js_used;
+size_t js_capacity;
+uint64_t js_start; //ns, CLOCK_MONOTONIC
+
+//regions
+struct region
+{
+  uint64_t first;
+  uint64_t last;
+  uint64_t branches;
+  uint64_t mispredicted;
+};
+struct region rg_regions[MAX_REGIONS];
+
+//prediction dump
+// Words are collected in a 1 MB block and written when it fills
+#define DUMP_BLOCK_WORDS (1 << 17)
+FILE *dp_file;
+uint64_t *dp_block;
+uint32_t dp_words;         //complete words in the block
+uint64_t dp_current;       //word being filled
+uint64_t dp_branches;
+
+//golden
+uint64_t *gd_words;        //golden stream
+uint64_t gd_length;        //branches in the golden stream
+uint64_t gd_branches;      //branches seen in this run
+uint64_t gd_differ;
+uint64_t gd_firstBranch;   //first diverging branch, valid when gd_differ
+uint32_t gd_firstPc;
+uint32_t gd_firstPrediction;
+
+//self profiling
+const char *st_phaseName[NUM_PHASES] = {"Ingest", "Predict", "Train", "Targets", "Other"};
+uint64_t st_wall[NUM_PHASES];   //ns
+uint64_t st_cpu[NUM_PHASES];    //ns
+uint64_t st_ticks[NUM_PHASES];  //cycle counter ticks inside simulation batches
+uint64_t st_startWall;
+uint64_t st_startCpu;
+uint64_t st_totalWall;
+uint64_t st_totalCpu;
+int st_batchPhase;
+uint64_t st_batchWall;
+uint64_t st_batchCpu;
+uint64_t st_batchTicks[NUM_PHASES];
+int st_phase;
+uint64_t st_lastTick;
+
+//host counters
+#define PERF_COUNTERS 5
+const char *pf_name[PERF_COUNTERS] = {"Cycles", "Instructions", "L1D Misses", "LLC Misses", "Branch Misses"};
+int pf_fd[PERF_COUNTERS];              //-1 when the counter could not be opened
+uint64_t pf_start[PERF_COUNTERS];      //values at the start of the batch
+uint64_t pf_ingest[PERF_COUNTERS];
+uint64_t pf_simulate[PERF_COUNTERS];
+
+//------------------------------------//
+//        Statistics Functions        //
+//------------------------------------//
+
+// profile functions
+uint32_t profile_hash(uint32_t pc, uint32_t seed)
+{
+  uint32_t h = (pc ^ seed) * 0x9E3779B1;
+  return h ^ (h >> 15);
+}
+
+void init_profile()
+{
+  if (profileMode == PROFILE_EXACT)
+  {
+    pr_capacity = 1 << PROFILE_INIT_BITS;
+    pr_used = 0;
+    pr_table = (struct profile_entry *)malloc(pr_capacity * sizeof(struct profile_entry));
+    memset(pr_table, 0, pr_capacity * sizeof(struct profile_entry));
+    for (uint32_t i = 0; i < pr_capacity; i++)
+    {
+      pr_table[i].pc = PROFILE_EMPTY;
+    }
+  }
+  else if (profileMode == PROFILE_SKETCH)
+  {
+    for (int r = 0; r < SKETCH_ROWS; r++)
+    {
+      sk_executed[r] = (uint32_t *)calloc(1 << SKETCH_BITS, sizeof(uint32_t));
+      sk_taken[r] = (uint32_t *)calloc(1 << SKETCH_BITS, sizeof(uint32_t));
+      sk_mispredicted[r] = (uint32_t *)calloc(1 << SKETCH_BITS, sizeof(uint32_t));
+    }
+    sk_numCandidates = 4 * profileTopN;
+    sk_candidates = (struct profile_entry *)calloc(sk_numCandidates, sizeof(struct profile_entry));
+  }
+}
+
+// Find the slot of 'pc', claiming an empty one if it is new
+//
+struct profile_entry *profile_slot(struct profile_entry *table, uint32_t capacity, uint32_t pc)
+{
+  uint32_t i = profile_hash(pc, 0) & (capacity - 1);
+  while (table[i].pc != pc && table[i].pc != PROFILE_EMPTY)
+  {
+    i = (i + 1) & (capacity - 1);
+  }
+  return &table[i];
+}
+
+void profile_grow()
+{
+  struct profile_entry *old = pr_table;
+  uint32_t old_capacity = pr_capacity;
+  pr_capacity *= 2;
+  pr_table = (struct profile_entry *)malloc(pr_capacity * sizeof(struct profile_entry));
+  memset(pr_table, 0, pr_capacity * sizeof(struct profile_entry));
+  for (uint32_t i = 0; i < pr_capacity; i++)
+  {
+    pr_table[i].pc = PROFILE_EMPTY;
+  }
+  for (uint32_t i = 0; i < old_capacity; i++)
+  {
+    if (old[i].pc != PROFILE_EMPTY)
+    {
+      *profile_slot(pr_table, pr_capacity, old[i].pc) = old[i];
+    }
+  }
+  free(old);
+}
+
+// Smallest counter over the sketch rows, the count-min estimate
+//
+uint32_t sketch_estimate(uint32_t **rows, uint32_t pc)
+{
+  uint32_t est = 0xffffffff;
+  for (int r = 0; r < SKETCH_ROWS; r++)
+  {
+    uint32_t v = rows[r][profile_hash(pc, (uint32_t)r * 0x7F4A7C15u) & ((1 << SKETCH_BITS) - 1)];
+    if (v < est)
+      est = v;
+  }
+  return est;
+}
+
+void sketch_add(uint32_t **rows, uint32_t pc)
+{
+  for (int r = 0; r < SKETCH_ROWS; r++)
+  {
+    rows[r][profile_hash(pc, (uint32_t)r * 0x7F4A7C15u) & ((1 << SKETCH_BITS) - 1)]++;
+  }
+}
+
+void sketch_branch(uint32_t pc, uint32_t outcome, uint32_t prediction)
+{
+  sketch_add(sk_executed, pc);
+  if (outcome == TAKEN)
+    sketch_add(sk_taken, pc);
+  if (outcome == prediction)
+    return;
+  sketch_add(sk_mispredicted, pc);
+
+  //keep the candidate set on the branches with the highest estimates
+  uint32_t est = sketch_estimate(sk_mispredicted, pc);
+  struct profile_entry *lowest = &sk_candidates[0];
+  for (uint32_t i = 0; i < sk_numCandidates; i++)
+  {
+    if (sk_candidates[i].pc == pc && sk_candidates[i].mispredicted)
+    {
+      sk_candidates[i].mispredicted = est;
+      return;
+    }
+    if (sk_candidates[i].mispredicted < lowest->mispredicted)
+      lowest = &sk_candidates[i];
+  }
+  if (est > lowest->mispredicted)
+  {
+    lowest->pc = pc;
+    lowest->mispredicted = est;
+  }
+}
+
+void profile_branch(uint32_t pc, uint32_t outcome, uint32_t prediction)
+{
+  if (profileMode == PROFILE_SKETCH)
+  {
+    sketch_branch(pc, outcome, prediction);
+    return;
+  }
+  struct profile_entry *e = profile_slot(pr_table, pr_capacity, pc);
+  if (e->pc == PROFILE_EMPTY)
+  {
+    e->pc = pc;
+    if (++pr_used * 2 > pr_capacity)
+    {
+      profile_grow();
+      e = profile_slot(pr_table, pr_capacity, pc);
+    }
+  }
+  e->executed++;
+  e->taken += outcome;
+  e->mispredicted += (outcome != prediction);
+}
+
+int profile_compare(const void *a, const void *b)
+{
+  const struct profile_entry *x = (const struct profile_entry *)a;
+  const struct profile_entry *y = (const struct profile_entry *)b;
+  if (x->mispredicted != y->mispredicted)
+    return (x->mispredicted < y->mispredicted) ? 1 : -1;
+  return (x->pc > y->pc) - (x->pc < y->pc);
+}
+
+// Profile entries sorted by mispredictions, to be freed by the caller
+//
+struct profile_entry *profile_list(uint32_t *length)
+{
+  struct profile_entry *list;
+  uint32_t count = 0;
+  if (profileMode == PROFILE_SKETCH)
+  {
+    list = (struct profile_entry *)malloc(sk_numCandidates * sizeof(struct profile_entry));
+    for (uint32_t i = 0; i < sk_numCandidates; i++)
+    {
+      if (sk_candidates[i].mispredicted)
+      {
+        list[count] = sk_candidates[i];
+        list[count].executed = sketch_estimate(sk_executed, list[count].pc);
+        list[count].taken = sketch_estimate(sk_taken, list[count].pc);
+        count++;
+      }
+    }
+  }
+  else
+  {
+    list = (struct profile_entry *)malloc(pr_used * sizeof(struct profile_entry));
+    for (uint32_t i = 0; i < pr_capacity; i++)
+    {
+      if (pr_table[i].pc != PROFILE_EMPTY)
+        list[count++] = pr_table[i];
+    }
+  }
+  qsort(list, count, sizeof(struct profile_entry), profile_compare);
+  *length = count;
+  return list;
+}
+
+void print_profile(uint64_t mispredictions)
+{
+  uint32_t count;
+  struct profile_entry *list = profile_list(&count);
+
+  printf("Hard Branches%s:\n", profileMode == PROFILE_SKETCH ? " (sketch estimates)" : "");
+  printf("%4s %10s %12s %8s %12s %8s %8s\n", "Rank", "PC", "Executed", "Taken%",
+         "Incorrect", "Rate", "Share%");
+  for (uint32_t i = 0; i < count && i < profileTopN; i++)
+  {
+    struct profile_entry *e = &list[i];
+    printf("%4u 0x%08x %12llu %8.2f %12llu %8.3f %8.2f\n", i + 1, e->pc,
+           (unsigned long long)e->executed,
+           e->executed ? 100 * ((float)e->taken / (float)e->executed) : 0,
+           (unsigned long long)e->mispredicted,
+           e->executed ? 1000 * ((float)e->mispredicted / (float)e->executed) : 0,
+           mispredictions ? 100 * ((float)e->mispredicted / (float)mispredictions) : 0);
+  }
+  free(list);
+}
+
+// instruction count functions
+int parse_instruction_line(const char *line)
+{
+  unsigned long long count;
+  if (sscanf(line, "!!! Number of Instructions = %llu", &count) == 1)
+  {
+    numInstructions = count;
+    return 1;
+  }
+  return 0;
+}
+
+int read_sidecar(const char *trace)
+{
+  //gen_trace.sh compresses <name> to <name>.bz2 and writes <name>.txt
+  size_t n = strlen(trace);
+  char *path = (char *)malloc(n + 5);
+  strcpy(path, trace);
+  if (n > 4 && !strcmp(path + n - 4, ".bz2"))
+  {
+    path[n - 4] = '\0';
+  }
+  strcat(path, ".txt");
+  int found = read_instruction_file(path);
+  free(path);
+  return found;
+}
+
+int read_instruction_file(const char *path)
+{
+  FILE *sidecar = fopen(path, "r");
+  if (sidecar == NULL)
+  {
+    return 0;
+  }
+  char *line = NULL;
+  size_t len = 0;
+  int found = 0;
+  while (!found && getline(&line, &len, sidecar) != -1)
+  {
+    found = parse_instruction_line(line);
+  }
+  free(line);
+  fclose(sidecar);
+  return found;
+}
+
+float mpki(uint64_t mispredictions)
+{
+  return numInstructions ? 1000 * ((float)mispredictions / (float)numInstructions) : 0;
+}
+
+// interval functions
+void init_interval()
+{
+  //JSON on stdout carries the rows instead of the CSV
+  iv_file = intervalPath ? fopen(intervalPath, "w") : (jsonEnabled && !jsonPath) ? NULL : stdout;
+  if (iv_file == NULL && (intervalPath || !jsonEnabled || jsonPath))
+  {
+    fprintf(stderr, "Warning: cannot open %s, writing intervals to stdout\n", intervalPath);
+    iv_file = stdout;
+  }
+  iv_buffer = (char *)malloc(INTERVAL_BUFFER_SIZE);
+  iv_used = snprintf(iv_buffer, INTERVAL_BUFFER_SIZE,
+                     "interval,first_branch,branches,mispredictions,taken_rate,misprediction_rate\n");
+  iv_index = 0;
+  iv_total = 0;
+  iv_branches = 0;
+  iv_taken = 0;
+  iv_mispredicted = 0;
+  iv_records = NULL;
+  iv_recordCapacity = 0;
+}
+
+void interval_flush()
+{
+  if (iv_file)
+  {
+    fwrite(iv_buffer, 1, iv_used, iv_file);
+  }
+  iv_used = 0;
+}
+
+void interval_row()
+{
+  if (iv_used + INTERVAL_ROW_MAX > INTERVAL_BUFFER_SIZE)
+  {
+    interval_flush();
+  }
+  iv_used += snprintf(iv_buffer + iv_used, INTERVAL_ROW_MAX, "%llu,%llu,%llu,%llu,%.4f,%.3f\n",
+                      (unsigned long long)iv_index, (unsigned long long)iv_total,
+                      (unsigned long long)iv_branches, (unsigned long long)iv_mispredicted,
+                      (double)iv_taken / (double)iv_branches,
+                      1000 * (double)iv_mispredicted / (double)iv_branches);
+  if (jsonEnabled)
+  {
+    if (iv_index == iv_recordCapacity)
+    {
+      iv_recordCapacity = iv_recordCapacity ? 2 * iv_recordCapacity : 256;
+      iv_records = (struct interval_record *)realloc(iv_records, iv_recordCapacity * sizeof(struct interval_record));
+    }
+    struct interval_record *r = &iv_records[iv_index];
+    r->first = iv_total;
+    r->branches = iv_branches;
+    r->taken = iv_taken;
+    r->mispredicted = iv_mispredicted;
+  }
+  iv_index++;
+  iv_total += iv_branches;
+  iv_branches = 0;
+  iv_taken = 0;
+  iv_mispredicted = 0;
+}
+
+void interval_branch(uint32_t outcome, uint32_t prediction)
+{
+  iv_branches++;
+  iv_taken += outcome;
+  iv_mispredicted += (outcome != prediction);
+  if (iv_branches == intervalLength)
+  {
+    interval_row();
+  }
+}
+
+void finish_interval()
+{
+  if (iv_branches)
+  {
+    interval_row();
+  }
+  interval_flush();
+  if (iv_file && iv_file != stdout)
+  {
+    fclose(iv_file);
+  }
+  free(iv_buffer);
+}
+
+// self profiling functions
+uint64_t clock_ns(clockid_t clock)
+{
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+uint64_t stats_ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return clock_ns(CLOCK_MONOTONIC);
+#endif
+}
+
+void init_self_stats()
+{
+  memset(st_wall, 0, sizeof(st_wall));
+  memset(st_cpu, 0, sizeof(st_cpu));
+  memset(st_ticks, 0, sizeof(st_ticks));
+  st_startWall = clock_ns(CLOCK_MONOTONIC);
+  st_startCpu = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+  st_phase = PHASE_OTHER;
+}
+
+void perf_read(uint64_t *values);
+void perf_accumulate(int phase);
+
+void stats_begin(int phase)
+{
+  if (perfEnabled)
+  {
+    perf_read(pf_start);
+  }
+  if (!statsEnabled)
+  {
+    st_batchPhase = phase;
+    return;
+  }
+  st_batchPhase = phase;
+  memset(st_batchTicks, 0, sizeof(st_batchTicks));
+  st_phase = phase;
+  st_batchWall = clock_ns(CLOCK_MONOTONIC);
+  st_batchCpu = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+  st_lastTick = stats_ticks();
+}
+
+void stats_switch(int phase)
+{
+  uint64_t now = stats_ticks();
+  st_batchTicks[st_phase] += now - st_lastTick;
+  st_lastTick = now;
+  st_phase = phase;
+}
+
+// Close a batch and split its clocks over the phases in proportion
+// to the ticks each of them used
+//
+void stats_end()
+{
+  if (perfEnabled)
+  {
+    perf_accumulate(st_batchPhase);
+  }
+  if (!statsEnabled)
+  {
+    return;
+  }
+  stats_switch(st_phase);
+  uint64_t wall = clock_ns(CLOCK_MONOTONIC) - st_batchWall;
+  uint64_t cpu = clock_ns(CLOCK_PROCESS_CPUTIME_ID) - st_batchCpu;
+  uint64_t total = 0;
+  for (int p = 0; p < NUM_PHASES; p++)
+  {
+    total += st_batchTicks[p];
+  }
+  if (total == 0 || st_batchPhase == PHASE_INGEST)
+  {
+    st_wall[st_batchPhase] += wall;
+    st_cpu[st_batchPhase] += cpu;
+    return;
+  }
+  for (int p = 0; p < NUM_PHASES; p++)
+  {
+    double share = (double)st_batchTicks[p] / (double)total;
+    st_wall[p] += (uint64_t)(wall * share);
+    st_cpu[p] += (uint64_t)(cpu * share);
+    st_ticks[p] += st_batchTicks[p];
+  }
+}
+
+void finish_self_stats()
+{
+  st_totalWall = clock_ns(CLOCK_MONOTONIC) - st_startWall;
+  st_totalCpu = clock_ns(CLOCK_PROCESS_CPUTIME_ID) - st_startCpu;
+}
+
+void print_self_stats(uint64_t records, uint64_t branches)
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  printf("Simulator Time:\n");
+  printf("  %-8s %10s %10s %8s\n", "Phase", "Wall(s)", "CPU(s)", "Wall%");
+  for (int p = 0; p < NUM_PHASES; p++)
+  {
+    printf("  %-8s %10.3f %10.3f %8.2f\n", st_phaseName[p], st_wall[p] / 1e9, st_cpu[p] / 1e9,
+           st_totalWall ? 100 * ((double)st_wall[p] / (double)st_totalWall) : 0);
+  }
+  printf("  %-8s %10.3f %10.3f\n", "Total", st_totalWall / 1e9, st_totalCpu / 1e9);
+  double seconds = st_totalWall / 1e9;
+  printf("Records per Second:  %12.0f\n", seconds > 0 ? records / seconds : 0);
+  printf("Branches per Second: %12.0f\n", seconds > 0 ? branches / seconds : 0);
+  //ru_maxrss is in kilobytes on Linux
+  printf("Peak RSS (KB):       %12ld\n", usage.ru_maxrss);
+}
+
+// host counter functions
+#ifdef __linux__
+int perf_open(uint32_t type, uint64_t config)
+{
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.exclude_kernel = 1; //allowed without privileges on most systems
+  attr.exclude_hv = 1;
+  return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+void init_perf()
+{
+  memset(pf_ingest, 0, sizeof(pf_ingest));
+  memset(pf_simulate, 0, sizeof(pf_simulate));
+#ifdef __linux__
+  uint64_t l1d_miss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  uint64_t llc_miss = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  pf_fd[0] = perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+  pf_fd[1] = perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+  pf_fd[2] = perf_open(PERF_TYPE_HW_CACHE, l1d_miss);
+  pf_fd[3] = perf_open(PERF_TYPE_HW_CACHE, llc_miss);
+  pf_fd[4] = perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+  for (int c = 0; c < PERF_COUNTERS; c++)
+  {
+    if (pf_fd[c] < 0)
+    {
+      fprintf(stderr, "Warning: cannot open host counter %s: %s\n", pf_name[c], strerror(errno));
+    }
+  }
+#else
+  for (int c = 0; c < PERF_COUNTERS; c++)
+  {
+    pf_fd[c] = -1;
+  }
+  fprintf(stderr, "Warning: host counters need perf_event_open (Linux)\n");
+#endif
+}
+
+void perf_read(uint64_t *values)
+{
+  for (int c = 0; c < PERF_COUNTERS; c++)
+  {
+    values[c] = 0;
+#ifdef __linux__
+    if (pf_fd[c] >= 0 && read(pf_fd[c], &values[c], sizeof(uint64_t)) != sizeof(uint64_t))
+    {
+      values[c] = 0;
+    }
+#endif
+  }
+}
+
+void perf_accumulate(int phase)
+{
+  uint64_t now[PERF_COUNTERS];
+  perf_read(now);
+  uint64_t *total = (phase == PHASE_INGEST) ? pf_ingest : pf_simulate;
+  for (int c = 0; c < PERF_COUNTERS; c++)
+  {
+    total[c] += now[c] - pf_start[c];
+  }
+}
+
+void print_perf_stats()
+{
+  printf("Host Counters:\n");
+  printf("  %-14s %16s %16s\n", "Counter", "Ingest", "Simulate");
+  for (int c = 0; c < PERF_COUNTERS; c++)
+  {
+    if (pf_fd[c] < 0)
+    {
+      printf("  %-14s %16s %16s\n", pf_name[c], "n/a", "n/a");
+      continue;
+    }
+    printf("  %-14s %16llu %16llu\n", pf_name[c], (unsigned long long)pf_ingest[c],
+           (unsigned long long)pf_simulate[c]);
+  }
+  if (pf_fd[0] >= 0 && pf_fd[1] >= 0)
+  {
+    printf("  %-14s %16.3f %16.3f\n", "IPC",
+           pf_ingest[0] ? (double)pf_ingest[1] / (double)pf_ingest[0] : 0,
+           pf_simulate[0] ? (double)pf_simulate[1] / (double)pf_simulate[0] : 0);
+  }
+}
+
+// region functions
+int add_region(uint64_t first, uint64_t last)
+{
+  if (numRegions == MAX_REGIONS || last <= first)
+  {
+    return 0;
+  }
+  struct region *r = &rg_regions[numRegions++];
+  r->first = first;
+  r->last = last;
+  r->branches = 0;
+  r->mispredicted = 0;
+  return 1;
+}
+
+void region_branch(uint64_t branch, uint32_t outcome, uint32_t prediction)
+{
+  for (int i = 0; i < numRegions; i++)
+  {
+    struct region *r = &rg_regions[i];
+    if (branch >= r->first && branch < r->last)
+    {
+      r->branches++;
+      r->mispredicted += (outcome != prediction);
+    }
+  }
+}
+
+void print_regions()
+{
+  printf("Regions:\n");
+  printf("  %12s %12s %12s %12s %8s\n", "First", "Last", "Branches", "Incorrect", "Rate");
+  for (int i = 0; i < numRegions; i++)
+  {
+    struct region *r = &rg_regions[i];
+    printf("  %12llu %12llu %12llu %12llu %8.3f\n", (unsigned long long)r->first, (unsigned long long)r->last,
+           (unsigned long long)r->branches, (unsigned long long)r->mispredicted,
+           r->branches ? 1000 * ((float)r->mispredicted / (float)r->branches) : 0);
+  }
+}
+
+// prediction dump functions
+void init_dump()
+{
+  dp_file = fopen(dumpPath, "wb");
+  uint64_t placeholder = 0;
+  if (dp_file == NULL || fwrite(STREAM_MAGIC, 1, 4, dp_file) != 4 ||
+      fwrite(&placeholder, sizeof(placeholder), 1, dp_file) != 1)
+  {
+    fprintf(stderr, "Cannot write prediction stream %s\n", dumpPath);
+    exit(1);
+  }
+  dp_block = (uint64_t *)malloc(DUMP_BLOCK_WORDS * sizeof(uint64_t));
+  dp_words = 0;
+  dp_current = 0;
+  dp_branches = 0;
+}
+
+void dump_flush()
+{
+  if (fwrite(dp_block, sizeof(uint64_t), dp_words, dp_file) != dp_words)
+  {
+    fprintf(stderr, "Cannot write prediction stream %s\n", dumpPath);
+    exit(1);
+  }
+  dp_words = 0;
+}
+
+void dump_branch(uint32_t prediction)
+{
+  dp_current |= (uint64_t)prediction << (dp_branches & 63);
+  if ((++dp_branches & 63) == 0)
+  {
+    dp_block[dp_words++] = dp_current;
+    dp_current = 0;
+    if (dp_words == DUMP_BLOCK_WORDS)
+    {
+      dump_flush();
+    }
+  }
+}
+
+void finish_dump()
+{
+  if (dp_branches & 63)
+  {
+    dp_block[dp_words++] = dp_current;
+  }
+  dump_flush();
+  //the count goes in the header now that it is known
+  if (fseek(dp_file, 4, SEEK_SET) || fwrite(&dp_branches, sizeof(dp_branches), 1, dp_file) != 1 ||
+      fclose(dp_file))
+  {
+    fprintf(stderr, "Cannot finish prediction stream %s, it must be a regular file\n", dumpPath);
+    exit(1);
+  }
+  free(dp_block);
+}
+
+// golden functions
+void init_golden()
+{
+  gd_branches = 0;
+  gd_differ = 0;
+  FILE *file = fopen(goldenCheckPath, "rb");
+  char magic[4];
+  uint64_t length;
+  if (file == NULL || fread(magic, 1, 4, file) != 4 || memcmp(magic, STREAM_MAGIC, 4) ||
+      fread(&length, sizeof(length), 1, file) != 1)
+  {
+    fprintf(stderr, "Cannot read golden stream %s\n", goldenCheckPath);
+    exit(1);
+  }
+  gd_length = length;
+  gd_words = (uint64_t *)calloc((length + 63) / 64 + 1, sizeof(uint64_t));
+  if (fread(gd_words, sizeof(uint64_t), (length + 63) / 64, file) != (length + 63) / 64)
+  {
+    fprintf(stderr, "Golden stream %s is truncated\n", goldenCheckPath);
+    exit(1);
+  }
+  fclose(file);
+}
+
+void golden_branch(uint32_t pc, uint32_t prediction)
+{
+  //past the end of the golden stream every branch differs
+  uint32_t golden = (gd_branches < gd_length) ? (gd_words[gd_branches >> 6] >> (gd_branches & 63)) & 1 : !prediction;
+  if (golden != prediction && gd_differ++ == 0)
+  {
+    gd_firstBranch = gd_branches;
+    gd_firstPc = pc;
+    gd_firstPrediction = prediction;
+  }
+  gd_branches++;
+}
+
+uint64_t finish_golden()
+{
+  if (gd_branches < gd_length)
+  {
+    //golden branches this run never reached
+    if (gd_differ == 0)
+    {
+      gd_firstBranch = gd_branches;
+    }
+    gd_differ += gd_length - gd_branches;
+  }
+  //stdout belongs to the JSON results when they go there
+  FILE *out = (jsonEnabled && !jsonPath) ? stderr : stdout;
+  fprintf(out, "Golden Check:    %s\n", gd_differ ? "FAIL" : "PASS");
+  if (gd_differ)
+  {
+    fprintf(out, "  Golden Branches:  %10llu\n", (unsigned long long)gd_length);
+    fprintf(out, "  Run Branches:     %10llu\n", (unsigned long long)gd_branches);
+    fprintf(out, "  Differing:        %10llu\n", (unsigned long long)gd_differ);
+    if (gd_firstBranch < gd_branches && gd_firstBranch < gd_length)
+    {
+      fprintf(out, "  First Divergence: branch %llu, pc 0x%x, golden %d, predicted %d\n",
+                    (unsigned long long)gd_firstBranch, gd_firstPc, !gd_firstPrediction, gd_firstPrediction);
+    }
+    else
+    {
+      fprintf(out, "  First Divergence: branch %llu, streams differ in length\n",
+                    (unsigned long long)gd_firstBranch);
+    }
+  }
+  free(gd_words);
+  return gd_differ;
+}
+
+// json functions
+void init_json()
+{
+  js_capacity = 1 << 16;
+  js_used = 0;
+  js_buffer = (char *)malloc(js_capacity);
+  js_start = clock_ns(CLOCK_MONOTONIC);
+}
+
+void json_printf(const char *format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(js_buffer + js_used, js_capacity - js_used, format, args);
+  va_end(args);
+  if (js_used + n >= js_capacity)
+  {
+    while (js_used + n >= js_capacity)
+    {
+      js_capacity *= 2;
+    }
+    js_buffer = (char *)realloc(js_buffer, js_capacity);
+    va_start(args, format);
+    vsnprintf(js_buffer + js_used, js_capacity - js_used, format, args);
+    va_end(args);
+  }
+  js_used += n;
+}
+
+void json_string(const char *str)
+{
+  json_printf("\"");
+  for (; *str; str++)
+  {
+    if (*str == '"' || *str == '\\')
+      json_printf("\\%c", *str);
+    else if ((unsigned char)*str < 0x20)
+      json_printf("\\u%04x", *str);
+    else
+      json_printf("%c", *str);
+  }
+  json_printf("\"");
+}
+
+void write_json(const char *trace, uint64_t records, uint64_t branches, uint64_t mispredictions)
+{
+  double seconds = (clock_ns(CLOCK_MONOTONIC) - js_start) / 1e9;
+
+  json_printf("{\n  \"trace\": ");
+  if (trace)
+    json_string(trace);
+  else
+    json_printf("null");
+  json_printf(",\n  \"predictor\": ");
+  json_string(bpName[bpType]);
+  if (bpType == CUSTOM)
+  {
+    json_printf(",\n  \"custom\": ");
+    json_string(customName[customType]);
+  }
+
+  struct predictor_param params[MAX_PREDICTOR_PARAMS];
+  int n = predictor_params(params, MAX_PREDICTOR_PARAMS);
+  json_printf(",\n  \"config\": {");
+  for (int i = 0; i < n; i++)
+  {
+    json_printf("%s\"%s\": %d", i ? ", " : "", params[i].name, params[i].value);
+  }
+  json_printf("},\n");
+  json_printf("  \"budget_bits\": %llu,\n", (unsigned long long)predictor_budget_bits());
+  json_printf("  \"budget_limit_bits\": %d,\n", BUDGET_BITS);
+  json_printf("  \"records\": %llu,\n", (unsigned long long)records);
+  json_printf("  \"branches\": %llu,\n", (unsigned long long)branches);
+  json_printf("  \"mispredictions\": %llu,\n", (unsigned long long)mispredictions);
+  json_printf("  \"misprediction_rate\": %.6f,\n", branches ? (double)mispredictions / (double)branches : 0);
+  if (numInstructions)
+  {
+    json_printf("  \"instructions\": %llu,\n", (unsigned long long)numInstructions);
+    json_printf("  \"mpki\": %.4f,\n", mpki(mispredictions));
+    //scaled to the scored records by main when there is a warmup
+    json_printf("  \"instructions_estimated\": %s,\n", warmupBranches ? "true" : "false");
+  }
+  else
+  {
+    json_printf("  \"instructions\": null,\n  \"mpki\": null,\n  \"instructions_estimated\": false,\n");
+  }
+  json_printf("  \"warmup_branches\": %llu,\n", (unsigned long long)warmupBranches);
+  json_printf("  \"run_time_s\": %.6f", seconds);
+
+  if (numRegions)
+  {
+    json_printf(",\n  \"regions\": [");
+    for (int i = 0; i < numRegions; i++)
+    {
+      struct region *r = &rg_regions[i];
+      json_printf("%s\n    {\"first\": %llu, \"last\": %llu, \"branches\": %llu, \"mispredictions\": %llu, \"misprediction_rate\": %.6f}",
+                  i ? "," : "", (unsigned long long)r->first, (unsigned long long)r->last,
+                  (unsigned long long)r->branches, (unsigned long long)r->mispredicted,
+                  r->branches ? (double)r->mispredicted / (double)r->branches : 0);
+    }
+    json_printf("\n  ]");
+  }
+
+  if (intervalLength)
+  {
+    json_printf(",\n  \"interval_length\": %llu,\n  \"intervals\": [", (unsigned long long)intervalLength);
+    for (uint64_t i = 0; i < iv_index; i++)
+    {
+      struct interval_record *r = &iv_records[i];
+      json_printf("%s\n    {\"first_branch\": %llu, \"branches\": %llu, \"mispredictions\": %llu, \"taken_rate\": %.4f}",
+                  i ? "," : "", (unsigned long long)r->first, (unsigned long long)r->branches,
+                  (unsigned long long)r->mispredicted, (double)r->taken / (double)r->branches);
+    }
+    json_printf("\n  ]");
+    free(iv_records);
+  }
+
+  if (profileMode != PROFILE_OFF)
+  {
+    uint32_t count;
+    struct profile_entry *list = profile_list(&count);
+    json_printf(",\n  \"hard_branches\": [");
+    for (uint32_t i = 0; i < count && i < profileTopN; i++)
+    {
+      struct profile_entry *e = &list[i];
+      json_printf("%s\n    {\"pc\": \"0x%08x\", \"executed\": %llu, \"taken\": %llu, \"mispredictions\": %llu}",
+                  i ? "," : "", e->pc, (unsigned long long)e->executed, (unsigned long long)e->taken,
+                  (unsigned long long)e->mispredicted);
+    }
+    json_printf("\n  ]");
+    if (profileMode == PROFILE_SKETCH)
+    {
+      json_printf(",\n  \"hard_branches_estimated\": true");
+    }
+    free(list);
+  }
+  json_printf("\n}\n");
+
+  FILE *file = jsonPath ? fopen(jsonPath, "w") : stdout;
+  if (file == NULL || fwrite(js_buffer, 1, js_used, file) != js_used)
+  {
+    fprintf(stderr, "Cannot write JSON results to %s\n", jsonPath ? jsonPath : "stdout");
+  }
+  if (file && file != stdout)
+  {
+    fclose(file);
+  }
+  free(js_buffer);
+}
@@ -0,0 +1,150 @@
+//========================================================//
+//  stats.h                                               //
+//  Header file for the Simulator Statistics              //
+//                                                        //
+//  Reporting beyond the total misprediction count        //
+//========================================================//
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+//------------------------------------//
+//        Statistics Configuration    //
+//------------------------------------//
+
+// Per branch profile modes
+#define PROFILE_OFF 0
+#define PROFILE_EXACT 1  // open addressing table, one entry per static branch
+#define PROFILE_SKETCH 2 // count-min sketch, fixed memory for huge traces
+
+extern int profileMode;
+extern int profileTopN; // Number of branches in the hard branch report
+
+// Instructions the trace covers, 0 when unknown. Read from the
+// branchExtractor sidecar "<trace>.txt", from "!!!" header lines in
+// the trace itself, or given with --instructions
+extern uint64_t numInstructions;
+
+// Conditional branches predicted and trained but left out of the
+// totals, so cold tables do not skew short traces
+extern uint64_t warmupBranches;
+// Scored regions, half open ranges of conditional branch ordinals
+#define MAX_REGIONS 16
+extern int numRegions;
+
+extern uint64_t intervalLength; // Conditional branches per CSV row, 0 disables
+extern const char *intervalPath; // CSV destination, stdout when NULL
+
+// Simulator self profiling phases
+#define PHASE_INGEST 0  // decompression and parsing of the trace
+#define PHASE_PREDICT 1 // direction prediction
+#define PHASE_TRAIN 2   // direction predictor training
+#define PHASE_TARGETS 3 // target predictors, BTB and RAS
+#define PHASE_OTHER 4   // scoring and reporting
+#define NUM_PHASES 5
+#define STATS_BATCH 4096 // trace records read per ingest batch
+
+// Prediction streams, dumped for bitdiff or checked against a golden run
+#define STREAM_MAGIC "BPG1"
+extern const char *dumpPath;        // record this run's predictions
+extern const char *goldenCheckPath; // compare with a recorded run
+
+// Machine readable results
+extern int jsonEnabled;
+extern const char *jsonPath; // JSON destination, replaces the text report on stdout when NULL
+
+extern int statsEnabled;
+extern int perfEnabled; // Host hardware counters around the trace loop
+
+//------------------------------------//
+//   Statistics Function Prototypes   //
+//------------------------------------//
+
+// Per branch misprediction profile
+void init_profile();
+void profile_branch(uint32_t pc, uint32_t outcome, uint32_t prediction);
+void print_profile(uint64_t mispredictions);
+
+// Instruction counts
+//
+// Parse a "!!! Number of Instructions = <n>" line, returns True if it was one
+int parse_instruction_line(const char *line);
+// Read the sidecar written next to 'trace' by gen_trace.sh, returns
+// True if it held an instruction count
+int read_sidecar(const char *trace);
+// Same for a sidecar given by its own path
+int read_instruction_file(const char *path);
+// Mispredictions per thousand instructions, 0 when the count is unknown
+float mpki(uint64_t mispredictions);
+
+// Interval time series
+//
+// One CSV row of branches, mispredictions and taken rate every
+// intervalLength conditional branches, plus a final partial row
+void init_interval();
+void interval_branch(uint32_t outcome, uint32_t prediction);
+void finish_interval();
+
+// Scored regions
+//
+// Each region counts the branches whose ordinal, warmup included, falls
+// in [first, last). Regions may overlap. Returns False when full
+int add_region(uint64_t first, uint64_t last);
+void region_branch(uint64_t branch, uint32_t outcome, uint32_t prediction);
+void print_regions();
+
+// Prediction streams
+//
+// One bit per conditional branch, packed little endian into 64-bit
+// words after the magic and the branch count. Dumps are streamed to a
+// regular file, the count is filled in at the end
+void init_dump();
+void dump_branch(uint32_t prediction);
+void finish_dump();
+// The golden stream is read whole, so it may be a pipe from bunzip2
+void init_golden();
+void golden_branch(uint32_t pc, uint32_t prediction);
+// Report the first branch that diverges from the golden stream.
+// Returns the number of branches that differ
+uint64_t finish_golden();
+
+// JSON results
+//
+// The document is built in memory and written with a single fwrite
+// once the run is over. Intervals and the hard branch profile are
+// included when those reports are enabled
+void init_json();
+void write_json(const char *trace, uint64_t records, uint64_t branches, uint64_t mispredictions);
+
+// Simulator self profiling
+//
+// Wall and CPU clocks are read around each ingest and simulation batch.
+// Inside a simulation batch stats_phase() attributes cheap cycle counter
+// ticks to phases, which split the batch's time between them
+void init_self_stats();
+void stats_begin(int phase);
+void stats_end();
+void stats_switch(int phase);
+void finish_self_stats();
+void print_self_stats(uint64_t records, uint64_t branches);
+
+// Host hardware counters
+//
+// Opened with perf_event_open for this process only and read around
+// the same ingest and simulation batches as the self profiling
+void init_perf();
+void print_perf_stats();
+
+// Free when --stats is off, a single well predicted branch
+static inline void stats_phase(int phase)
+{
+  if (statsEnabled)
+  {
+    stats_switch(phase);
+  }
+}
+
+#endif
@@ -0,0 +1,504 @@
+//========================================================//
+//  target.cpp                                            //
+//  Source file for the Branch Target Predictors          //
+//                                                        //
+//  Target predictors run alongside the direction         //
+//  predictors and are scored separately                  //
+//========================================================//
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "predictor.h"
+#include "target.h"
+
+//------------------------------------//
+//     Target Predictor Configuration //
+//------------------------------------//
+int ittageEnabled = 0;
+int ittageTableBits = 9;   //log2 of the entries in each tagged table
+int rasEnabled = 0;
+int rasDepth = 16;
+int rasOverflow = RAS_WRAP;
+int btbEnabled = 0;
+int btbSetBits = 9;        //log2 of the number of btb sets
+int btbWays = 4;
+int btbTagBits = 16;
+int btbReplacement = BTB_LRU;
+
+//------------------------------------//
+//   Target Predictor Data Structures //
+//------------------------------------//
+
+//ittage
+// A pc indexed base table of targets plus tagged tables indexed with
+// geometrically longer slices of a history of conditional outcomes and
+// indirect targets. The longest matching table provides the target.
+#define IT_TABLES 4
+#define IT_TAG_BITS 11
+#define IT_VALID 0x8000 //tag bit marking a used entry
+#define IT_CONF_MAX 3
+const int it_historyLengths[IT_TABLES] = {4, 12, 28, 60};
+struct ittage_entry
+{
+  uint32_t target;
+  uint16_t tag;
+  uint8_t conf;
+  uint8_t useful;
+};
+uint32_t *it_base;                         //pc indexed targets
+struct ittage_entry *it_tables[IT_TABLES];
+uint64_t it_history;
+uint32_t it_index[IT_TABLES];              //rows and tags of the branch in flight
+uint16_t it_tag[IT_TABLES];
+
+//ras
+// Circular buffer so wrapping on overflow just moves the top pointer
+#define RAS_MAX_CALL_BYTES 15 //longest x86 instruction
+uint32_t *ras_stack;
+uint32_t ras_top;    //index of the newest entry
+uint32_t ras_count;  //valid entries, at most rasDepth
+uint64_t ras_overflows;
+uint64_t ras_underflows;
+
+//btb
+// Set associative, the replacement state is an LRU timestamp or an
+// SRRIP re-reference prediction value depending on btbReplacement
+#define BTB_VALID 0x80000000 //tag bit marking a used entry
+#define BTB_RRPV_MAX 3       //2 bit re-reference prediction values
+struct btb_entry
+{
+  uint32_t tag;
+  uint32_t target;
+  uint64_t state;
+};
+struct btb_entry *btb_table;
+uint64_t btb_clock;
+uint32_t btb_rng;
+uint64_t btb_lookups;      //taken branches looked up
+uint64_t btb_hits;
+uint64_t btb_targetMisses; //hits whose stored target was wrong
+
+//------------------------------------//
+//     Target Predictor Functions     //
+//------------------------------------//
+
+// ittage functions
+void init_ittage()
+{
+  uint32_t entries = 1 << ittageTableBits;
+  it_base = (uint32_t *)malloc(entries * sizeof(uint32_t));
+  memset(it_base, 0, entries * sizeof(uint32_t));
+  for (int t = 0; t < IT_TABLES; t++)
+  {
+    it_tables[t] = (struct ittage_entry *)malloc(entries * sizeof(struct ittage_entry));
+    memset(it_tables[t], 0, entries * sizeof(struct ittage_entry));
+  }
+  it_history = 0;
+}
+
+// Fold the first 'length' history bits down to 'bits' bits
+//
+uint32_t it_fold(int length, int bits)
+{
+  uint64_t hist = (length >= 64) ? it_history : (it_history & ((1ull << length) - 1));
+  uint32_t folded = 0;
+  while (hist)
+  {
+    folded ^= hist & ((1 << bits) - 1);
+    hist >>= bits;
+  }
+  return folded;
+}
+
+void it_compute_indices(uint32_t pc)
+{
+  uint32_t mask = (1 << ittageTableBits) - 1;
+  for (int t = 0; t < IT_TABLES; t++)
+  {
+    int length = it_historyLengths[t];
+    it_index[t] = (pc ^ (pc >> ittageTableBits) ^ it_fold(length, ittageTableBits)) & mask;
+    //tags fold with a different width so they decorrelate from the index
+    it_tag[t] = (((pc >> 2) ^ it_fold(length, IT_TAG_BITS) ^ (it_fold(length, IT_TAG_BITS - 1) << 1)) &
+                 ((1 << IT_TAG_BITS) - 1)) | IT_VALID;
+  }
+}
+
+// Find the longest and second longest matching tables, -1 if none
+//
+void it_find_providers(int *provider, int *alternate)
+{
+  *provider = -1;
+  *alternate = -1;
+  for (int t = IT_TABLES - 1; t >= 0; t--)
+  {
+    if (it_tables[t][it_index[t]].tag == it_tag[t])
+    {
+      if (*provider < 0)
+      {
+        *provider = t;
+      }
+      else
+      {
+        *alternate = t;
+        return;
+      }
+    }
+  }
+}
+
+uint32_t it_entry_target(uint32_t pc, int table)
+{
+  if (table < 0)
+  {
+    return it_base[pc & ((1 << ittageTableBits) - 1)];
+  }
+  return it_tables[table][it_index[table]].target;
+}
+
+uint32_t ittage_predict(uint32_t pc)
+{
+  int provider, alternate;
+  it_compute_indices(pc);
+  it_find_providers(&provider, &alternate);
+  //a freshly allocated entry is not trusted over the alternate
+  if (provider >= 0 && it_tables[provider][it_index[provider]].conf == 0)
+  {
+    return it_entry_target(pc, alternate);
+  }
+  return it_entry_target(pc, provider);
+}
+
+void train_ittage(uint32_t pc, uint32_t target, uint32_t outcome, uint32_t condition, uint32_t ret, uint32_t direct)
+{
+  if (condition)
+  {
+    it_history = (it_history << 1) | outcome;
+    return;
+  }
+  if (direct || ret)
+  {
+    return;
+  }
+
+  int provider, alternate;
+  it_compute_indices(pc);
+  it_find_providers(&provider, &alternate);
+  uint32_t provider_target = it_entry_target(pc, provider);
+  uint32_t alt_target = it_entry_target(pc, alternate);
+
+  if (provider >= 0)
+  {
+    struct ittage_entry *e = &it_tables[provider][it_index[provider]];
+    if (provider_target == target)
+    {
+      if (e->conf < IT_CONF_MAX)
+        e->conf++;
+      if (alt_target != target)
+        e->useful = 1;
+    }
+    else if (e->conf > 0)
+    {
+      e->conf--;
+    }
+    else
+    {
+      e->target = target;
+    }
+  }
+  else
+  {
+    it_base[pc & ((1 << ittageTableBits) - 1)] = target;
+  }
+
+  //allocate one entry in a longer table on a wrong target
+  if (provider_target != target)
+  {
+    int allocated = 0;
+    for (int t = provider + 1; t < IT_TABLES && !allocated; t++)
+    {
+      struct ittage_entry *e = &it_tables[t][it_index[t]];
+      if (!e->useful)
+      {
+        e->tag = it_tag[t];
+        e->target = target;
+        e->conf = 0;
+        allocated = 1;
+      }
+    }
+    if (!allocated)
+    {
+      for (int t = provider + 1; t < IT_TABLES; t++)
+      {
+        it_tables[t][it_index[t]].useful = 0;
+      }
+    }
+  }
+
+  //two bits of every indirect target enter the history
+  it_history = (it_history << 2) | ((target >> 2) & 3);
+}
+
+void print_ittage_stats(uint64_t num_indirect, uint64_t target_mispredictions)
+{
+  printf("Indirect:        %10llu\n", (unsigned long long)num_indirect);
+  printf("Target Incorrect:%10llu\n", (unsigned long long)target_mispredictions);
+  float rate = num_indirect ? 1000 * ((float)target_mispredictions / (float)num_indirect) : 0;
+  printf("Target Misprediction Rate: %7.3f\n", rate);
+}
+
+void cleanup_ittage()
+{
+  free(it_base);
+  for (int t = 0; t < IT_TABLES; t++)
+  {
+    free(it_tables[t]);
+  }
+}
+
+// ras functions
+void init_ras()
+{
+  ras_stack = (uint32_t *)malloc(rasDepth * sizeof(uint32_t));
+  memset(ras_stack, 0, rasDepth * sizeof(uint32_t));
+  ras_top = rasDepth - 1;
+  ras_count = 0;
+  ras_overflows = 0;
+  ras_underflows = 0;
+}
+
+// Call site on top of the stack, 0 when the stack is empty
+//
+uint32_t ras_predict()
+{
+  return ras_count ? ras_stack[ras_top] : 0;
+}
+
+int ras_return_matches(uint32_t call_pc, uint32_t target)
+{
+  return call_pc != 0 && target > call_pc && target - call_pc <= RAS_MAX_CALL_BYTES;
+}
+
+void train_ras(uint32_t pc, uint32_t call, uint32_t ret)
+{
+  if (call)
+  {
+    if (ras_count == rasDepth)
+    {
+      ras_overflows += scoredBranch;
+      if (rasOverflow == RAS_DROP)
+      {
+        return;
+      }
+      ras_count--; //the oldest entry gets overwritten
+    }
+    ras_top = (ras_top + 1) % rasDepth;
+    ras_stack[ras_top] = pc;
+    ras_count++;
+  }
+  else if (ret)
+  {
+    if (ras_count == 0)
+    {
+      ras_underflows += scoredBranch;
+      return;
+    }
+    ras_top = (ras_top + rasDepth - 1) % rasDepth;
+    ras_count--;
+  }
+}
+
+void print_ras_stats(uint64_t num_returns, uint64_t return_mispredictions)
+{
+  printf("Returns:         %10llu\n", (unsigned long long)num_returns);
+  printf("Return Incorrect:%10llu\n", (unsigned long long)return_mispredictions);
+  float rate = num_returns ? 1000 * ((float)return_mispredictions / (float)num_returns) : 0;
+  printf("Return Misprediction Rate: %7.3f\n", rate);
+  printf("RAS Overflows:   %10llu\n", (unsigned long long)ras_overflows);
+  printf("RAS Underflows:  %10llu\n", (unsigned long long)ras_underflows);
+}
+
+void cleanup_ras()
+{
+  free(ras_stack);
+}
+
+// btb functions
+void init_btb()
+{
+  uint32_t entries = btbWays << btbSetBits;
+  btb_table = (struct btb_entry *)malloc(entries * sizeof(struct btb_entry));
+  memset(btb_table, 0, entries * sizeof(struct btb_entry));
+  btb_clock = 0;
+  btb_rng = 0x2545F491;
+  btb_lookups = 0;
+  btb_hits = 0;
+  btb_targetMisses = 0;
+}
+
+uint32_t btb_tag(uint32_t pc)
+{
+  //up to 31 tag bits, bit 31 is BTB_VALID
+  return ((pc >> btbSetBits) & ((1u << btbTagBits) - 1)) | BTB_VALID;
+}
+
+struct btb_entry *btb_set(uint32_t pc)
+{
+  return &btb_table[(pc & ((1 << btbSetBits) - 1)) * btbWays];
+}
+
+// xorshift, keeps random replacement reproducible between runs
+//
+uint32_t btb_random()
+{
+  btb_rng ^= btb_rng << 13;
+  btb_rng ^= btb_rng >> 17;
+  btb_rng ^= btb_rng << 5;
+  return btb_rng;
+}
+
+void btb_touch(struct btb_entry *e, int hit)
+{
+  if (btbReplacement == BTB_LRU)
+  {
+    e->state = ++btb_clock;
+  }
+  else if (btbReplacement == BTB_SRRIP)
+  {
+    //hits are promoted to near reuse, fills start at long reuse
+    e->state = hit ? 0 : BTB_RRPV_MAX - 1;
+  }
+}
+
+struct btb_entry *btb_victim(struct btb_entry *set)
+{
+  for (int w = 0; w < btbWays; w++)
+  {
+    if (!(set[w].tag & BTB_VALID))
+    {
+      return &set[w];
+    }
+  }
+  switch (btbReplacement)
+  {
+  case BTB_LRU:
+  {
+    struct btb_entry *victim = &set[0];
+    for (int w = 1; w < btbWays; w++)
+    {
+      if (set[w].state < victim->state)
+        victim = &set[w];
+    }
+    return victim;
+  }
+  case BTB_SRRIP:
+    //age the whole set until some entry predicts distant reuse
+    while (1)
+    {
+      for (int w = 0; w < btbWays; w++)
+      {
+        if (set[w].state >= BTB_RRPV_MAX)
+          return &set[w];
+      }
+      for (int w = 0; w < btbWays; w++)
+      {
+        set[w].state++;
+      }
+    }
+  default:
+    return &set[btb_random() % btbWays];
+  }
+}
+
+// Look up a taken branch and install or correct its target, counting
+// a miss when the pc is absent and a target miss when the stored
+// target is stale
+//
+void train_btb(uint32_t pc, uint32_t target, uint32_t outcome)
+{
+  if (!outcome)
+  {
+    return;
+  }
+  btb_lookups += scoredBranch;
+  struct btb_entry *set = btb_set(pc);
+  uint32_t tag = btb_tag(pc);
+  for (int w = 0; w < btbWays; w++)
+  {
+    if (set[w].tag == tag)
+    {
+      btb_hits += scoredBranch;
+      if (set[w].target != target)
+      {
+        btb_targetMisses += scoredBranch;
+        set[w].target = target;
+      }
+      btb_touch(&set[w], 1);
+      return;
+    }
+  }
+  struct btb_entry *e = btb_victim(set);
+  e->tag = tag;
+  e->target = target;
+  btb_touch(e, 0);
+}
+
+void print_btb_stats(uint64_t num_instructions)
+{
+  uint64_t misses = btb_lookups - btb_hits;
+  printf("BTB Lookups:     %10llu\n", (unsigned long long)btb_lookups);
+  printf("BTB Hit Rate:       %7.3f\n", btb_lookups ? 100 * ((float)btb_hits / (float)btb_lookups) : 0);
+  printf("BTB Misses:      %10llu\n", (unsigned long long)misses);
+  printf("BTB Target Misses:%9llu\n", (unsigned long long)btb_targetMisses);
+  float rate = btb_lookups ? 1000 * ((float)(misses + btb_targetMisses) / (float)btb_lookups) : 0;
+  printf("BTB Miss Rate:      %7.3f\n", rate);
+  //instruction counts are not part of the trace, MPKI needs them from elsewhere
+  if (num_instructions)
+  {
+    printf("BTB Miss MPKI:      %7.3f\n", 1000 * ((float)(misses + btb_targetMisses) / (float)num_instructions));
+  }
+}
+
+void cleanup_btb()
+{
+  free(btb_table);
+}
+
+// checkpoint functions
+int target_state_regions(struct state_region *regions, int max)
+{
+  int n = 0;
+#define REGION(ptr, size)             \
+  do                                  \
+  {                                   \
+    if (n < max)                      \
+    {                                 \
+      regions[n].name = #ptr;         \
+      regions[n].data = (void *)(ptr); \
+      regions[n].bytes = (size);      \
+      n++;                            \
+    }                                 \
+  } while (0)
+  if (ittageEnabled)
+  {
+    REGION(it_base, sizeof(uint32_t) << ittageTableBits);
+    for (int t = 0; t < IT_TABLES; t++)
+    {
+      REGION(it_tables[t], sizeof(struct ittage_entry) << ittageTableBits);
+    }
+    REGION(&it_history, sizeof(it_history));
+  }
+  if (rasEnabled)
+  {
+    REGION(ras_stack, rasDepth * sizeof(uint32_t));
+    REGION(&ras_top, sizeof(ras_top));
+    REGION(&ras_count, sizeof(ras_count));
+  }
+  if (btbEnabled)
+  {
+    REGION(btb_table, (sizeof(struct btb_entry) * btbWays) << btbSetBits);
+    REGION(&btb_clock, sizeof(btb_clock));
+    REGION(&btb_rng, sizeof(btb_rng));
+  }
+#undef REGION
+  return n;
+}
@@ -0,0 +1,75 @@
+//========================================================//
+//  target.h                                              //
+//  Header file for the Branch Target Predictors          //
+//                                                        //
+//  Models that predict where a branch goes rather than   //
+//  whether it is taken                                   //
+//========================================================//
+
+#ifndef TARGET_H
+#define TARGET_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+//------------------------------------//
+//     Target Predictor Configuration //
+//------------------------------------//
+extern int ittageEnabled;   // Predict targets of indirect jumps and calls
+extern int ittageTableBits; // log2 of the entries in each ITTAGE table
+extern int rasEnabled;      // Predict return targets with a return address stack
+extern int rasDepth;        // Number of return address stack entries
+extern int rasOverflow;     // What a push onto a full stack does
+extern int btbEnabled;      // Model a branch target buffer
+extern int btbSetBits;      // log2 of the number of BTB sets
+extern int btbWays;         // BTB associativity
+extern int btbTagBits;      // BTB tag width
+extern int btbReplacement;  // BTB replacement policy
+
+// BTB replacement policies
+#define BTB_LRU 0
+#define BTB_SRRIP 1
+#define BTB_RANDOM 2
+
+// Return address stack overflow behaviors
+#define RAS_WRAP 0 // overwrite the oldest entry
+#define RAS_DROP 1 // discard the new entry
+
+//------------------------------------//
+//  Target Predictor Function Prototypes
+//------------------------------------//
+
+// ITTAGE indirect target predictor
+//
+// Indirect branches are the non-direct jumps and calls in the trace,
+// returns are left to a return address stack
+void init_ittage();
+uint32_t ittage_predict(uint32_t pc);
+void train_ittage(uint32_t pc, uint32_t target, uint32_t outcome, uint32_t condition, uint32_t ret, uint32_t direct);
+void print_ittage_stats(uint64_t num_indirect, uint64_t target_mispredictions);
+
+// Return address stack
+//
+// Traces only carry the pc of a call, not its length, so the stack holds
+// call sites and a return counts as predicted when it lands within one
+// x86 instruction length after the call on top of the stack. Only the
+// correct path is in the trace, so the stack never needs repair
+void init_ras();
+uint32_t ras_predict();
+int ras_return_matches(uint32_t call_pc, uint32_t target);
+void train_ras(uint32_t pc, uint32_t call, uint32_t ret);
+void print_ras_stats(uint64_t num_returns, uint64_t return_mispredictions);
+
+// Checkpoint regions of the enabled target predictors, appended to
+// the direction predictor's by state_regions()
+struct state_region;
+int target_state_regions(struct state_region *regions, int max);
+
+// Branch target buffer
+//
+// Trained with the pc and target of every taken branch
+void init_btb();
+void train_btb(uint32_t pc, uint32_t target, uint32_t outcome);
+void print_btb_stats(uint64_t num_instructions);
+
+#endif
@@ -0,0 +1,123 @@
+//========================================================//
+//  trace.cpp                                             //
+//  Source file for the Trace Reader                      //
+//                                                        //
+//  One branch per line: PC, target, taken, conditional,  //
+//  call, ret and direct, tab separated                   //
+//  or the fixed size binary records tracegen writes      //
+//========================================================//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stats.h"
+#include "trace.h"
+
+FILE *stream;
+char *buf = NULL;
+size_t len = 0;
+
+//format is detected from the first byte, text lines start with 0x or !!!
+int traceFormat = -1; // -1 unknown, 0 text, 1 binary
+
+//binary records are read in large blocks rather than per record
+#define BIN_BLOCK (TRACE_RECORD_LEN * 8192)
+uint8_t *binBuf;
+size_t binPos, binLen;
+
+int detect_format()
+{
+  int c = getc(stream);
+  if (c == EOF)
+  {
+    return 0;
+  }
+  if (c != TRACE_MAGIC[0])
+  {
+    ungetc(c, stream);
+    return 0;
+  }
+  char magic[TRACE_MAGIC_LEN];
+  magic[0] = c;
+  if (fread(magic + 1, 1, TRACE_MAGIC_LEN - 1, stream) != TRACE_MAGIC_LEN - 1 ||
+      memcmp(magic, TRACE_MAGIC, TRACE_MAGIC_LEN))
+  {
+    fprintf(stderr, "Unrecognized trace format\n");
+    exit(1);
+  }
+  binBuf = (uint8_t *)malloc(BIN_BLOCK);
+  binPos = binLen = 0;
+  return 1;
+}
+
+uint32_t load_le32(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int read_binary_branch(uint32_t *pc, uint32_t *target, uint32_t *outcome, uint32_t *condition, uint32_t *call, uint32_t *ret, uint32_t *direct)
+{
+  if (binLen - binPos < TRACE_RECORD_LEN)
+  {
+    //keep the partial record, if any, and refill behind it
+    memmove(binBuf, binBuf + binPos, binLen - binPos);
+    binLen -= binPos;
+    binPos = 0;
+    binLen += fread(binBuf + binLen, 1, BIN_BLOCK - binLen, stream);
+    if (binLen < TRACE_RECORD_LEN)
+    {
+      return 0;
+    }
+  }
+  const uint8_t *r = binBuf + binPos;
+  binPos += TRACE_RECORD_LEN;
+  *pc = load_le32(r);
+  *target = load_le32(r + 4);
+  *outcome = (r[8] & TRACE_TAKEN) != 0;
+  *condition = (r[8] & TRACE_CONDITION) != 0;
+  *call = (r[8] & TRACE_CALL) != 0;
+  *ret = (r[8] & TRACE_RET) != 0;
+  *direct = (r[8] & TRACE_DIRECT) != 0;
+  return 1;
+}
+
+int read_branch(uint32_t *pc, uint32_t *target, uint32_t *outcome, uint32_t *condition, uint32_t *call, uint32_t *ret, uint32_t *direct)
+{
+  if (traceFormat < 0)
+  {
+    traceFormat = detect_format();
+  }
+  if (traceFormat)
+  {
+    return read_binary_branch(pc, target, outcome, condition, call, ret, direct);
+  }
+
+  if (getline(&buf, &len, stream) == -1)
+  {
+    return 0;
+  }
+
+  //traces may carry the sidecar's "!!!" summary lines as a header
+  while (buf[0] == '!')
+  {
+    parse_instruction_line(buf);
+    if (getline(&buf, &len, stream) == -1)
+    {
+      return 0;
+    }
+  }
+
+  sscanf(buf, "0x%x\t0x%x\t%d\t%d\t%d\t%d\t%d\n", pc, target, outcome, condition, call, ret, direct);
+
+  return 1;
+}
+
+void close_trace()
+{
+  fclose(stream);
+  free(buf);
+  buf = NULL;
+  len = 0;
+  free(binBuf);
+  binBuf = NULL;
+  traceFormat = -1;
+}
@@ -0,0 +1,39 @@
+//========================================================//
+//  trace.h                                               //
+//  Header file for the Trace Reader                      //
+//                                                        //
+//  Reads branch records from the input stream            //
+//========================================================//
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Binary traces start with TRACE_MAGIC and hold fixed size
+// little endian records: PC, target, then one flags byte
+#define TRACE_MAGIC "BPT1"
+#define TRACE_MAGIC_LEN 4
+#define TRACE_RECORD_LEN 9
+
+#define TRACE_TAKEN 0x01
+#define TRACE_CONDITION 0x02
+#define TRACE_CALL 0x04
+#define TRACE_RET 0x08
+#define TRACE_DIRECT 0x10
+
+// Stream the trace is read from, stdin unless a file is given
+extern FILE *stream;
+
+// Reads a line (or a binary record) from the input stream
+// and extracts the PC and Outcome of a branch
+//
+// Returns True if Successful
+//
+int read_branch(uint32_t *pc, uint32_t *target, uint32_t *outcome, uint32_t *condition, uint32_t *call, uint32_t *ret, uint32_t *direct);
+
+// Close the stream and release the line buffer
+void close_trace();
+
+#endif
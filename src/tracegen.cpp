@@ -0,0 +1,372 @@
+//========================================================//
+//  tracegen.cpp                                          //
+//  Synthetic trace generator                             //
+//                                                        //
+//  Writes reproducible traces in the 7 field text format //
+//  or the binary record format from simple branch models //
+//========================================================//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "trace.h"
+
+//------------------------------------//
+//      Generator Configuration       //
+//------------------------------------//
+
+// Branch models a static branch site can follow
+#define MODEL_LOOP 0     // taken trip-1 times, then not taken
+#define MODEL_CORR 1     // repeats (or inverts) the outcome of its partner
+#define MODEL_BIAS 2     // taken with a fixed per site probability
+#define MODEL_INDIRECT 3 // unconditional jump through a dispatch table
+#define MODEL_CALL 4     // call and matching ret, nested up to maxDepth
+#define NUM_MODELS 5
+
+uint64_t numRecords = 10000000;
+int numStatic = 1024;
+uint32_t seed = 1;
+int binaryOutput = 0;
+const char *outPath = NULL;
+int mix[NUM_MODELS] = {30, 20, 30, 10, 10}; // relative weight of each model
+int minTrip = 2;
+int maxTrip = 32;
+int numTargets = 8;
+int maxDepth = 16;
+
+//------------------------------------//
+//      Generator Data Structures     //
+//------------------------------------//
+
+struct site
+{
+  uint32_t pc;
+  uint32_t target;
+  int model;
+  int trip;      // loop: trip count
+  int iteration; // loop: current iteration
+  int partner;   // corr: site whose outcome is repeated
+  int invert;    // corr: repeat the inverse outcome
+  uint32_t bias; // bias: taken probability out of 2^16
+  uint32_t *table; // indirect: dispatch targets
+};
+
+struct site *sites;
+uint8_t *lastOutcome; // per site, read by correlated partners
+
+uint32_t *callStack;  // return addresses of the open calls
+int depth;
+
+// Output is formatted into one large block and written in bulk
+#define OUT_BLOCK (1 << 20)
+char *out;
+size_t outLen;
+FILE *outFile;
+uint64_t written;
+
+//------------------------------------//
+//        Generator Functions         //
+//------------------------------------//
+
+// xorshift, every stream is fixed by --seed
+//
+uint32_t next_random()
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+uint32_t random_below(uint32_t n)
+{
+  return (uint32_t)(((uint64_t)next_random() * n) >> 32);
+}
+
+void flush_out()
+{
+  if (outLen && fwrite(out, 1, outLen, outFile) != outLen)
+  {
+    perror("tracegen: write");
+    exit(1);
+  }
+  outLen = 0;
+}
+
+char *put_hex(char *p, uint32_t v)
+{
+  static const char digits[] = "0123456789abcdef";
+  char tmp[8];
+  int n = 0;
+  do
+  {
+    tmp[n++] = digits[v & 0xf];
+    v >>= 4;
+  } while (v);
+  *p++ = '0';
+  *p++ = 'x';
+  while (n)
+    *p++ = tmp[--n];
+  return p;
+}
+
+// Append one record in the selected format
+//
+void emit(uint32_t pc, uint32_t target, int outcome, int condition, int call, int ret, int direct)
+{
+  if (OUT_BLOCK - outLen < 64)
+  {
+    flush_out();
+  }
+  char *p = out + outLen;
+  if (binaryOutput)
+  {
+    uint32_t v[2] = {pc, target};
+    for (int w = 0; w < 2; w++)
+      for (int b = 0; b < 4; b++)
+        *p++ = (v[w] >> (8 * b)) & 0xff;
+    *p++ = (outcome ? TRACE_TAKEN : 0) | (condition ? TRACE_CONDITION : 0) |
+           (call ? TRACE_CALL : 0) | (ret ? TRACE_RET : 0) | (direct ? TRACE_DIRECT : 0);
+  }
+  else
+  {
+    p = put_hex(p, pc);
+    *p++ = '\t';
+    p = put_hex(p, target);
+    *p++ = '\t';
+    *p++ = '0' + outcome;
+    *p++ = '\t';
+    *p++ = '0' + condition;
+    *p++ = '\t';
+    *p++ = '0' + call;
+    *p++ = '\t';
+    *p++ = '0' + ret;
+    *p++ = '\t';
+    *p++ = '0' + direct;
+    *p++ = '\n';
+  }
+  outLen = p - out;
+  written++;
+}
+
+// Lay out the static branches, each with a distinct pc and a
+// model drawn from the mix
+//
+void init_sites()
+{
+  int total = 0;
+  for (int m = 0; m < NUM_MODELS; m++)
+  {
+    total += mix[m];
+  }
+
+  sites = (struct site *)calloc(numStatic, sizeof(struct site));
+  lastOutcome = (uint8_t *)calloc(numStatic, 1);
+  for (int i = 0; i < numStatic; i++)
+  {
+    struct site *s = &sites[i];
+    int pick = random_below(total);
+    s->model = 0;
+    while (pick >= mix[s->model])
+      pick -= mix[s->model++];
+
+    //spread the sites over a code region, 16 bytes apart
+    s->pc = 0x400000 + i * 16;
+    s->target = 0x400000 + random_below(numStatic) * 16;
+    switch (s->model)
+    {
+    case MODEL_LOOP:
+      s->trip = minTrip + random_below(maxTrip - minTrip + 1);
+      s->target = s->pc - 16 * (1 + random_below(8));
+      break;
+    case MODEL_CORR:
+      s->partner = random_below(numStatic);
+      s->invert = random_below(2);
+      break;
+    case MODEL_BIAS:
+      s->bias = random_below(1 << 16);
+      break;
+    case MODEL_INDIRECT:
+      s->table = (uint32_t *)malloc(numTargets * sizeof(uint32_t));
+      for (int t = 0; t < numTargets; t++)
+        s->table[t] = 0x800000 + random_below(1 << 16) * 16;
+      break;
+    case MODEL_CALL:
+      s->target = 0xc00000 + i * 256;
+      break;
+    }
+  }
+  callStack = (uint32_t *)malloc(maxDepth * sizeof(uint32_t));
+  depth = 0;
+}
+
+// Visit one static branch and emit the records it produces
+//
+void visit(int i)
+{
+  struct site *s = &sites[i];
+  int outcome;
+  switch (s->model)
+  {
+  case MODEL_LOOP:
+    //the whole loop runs back to back, as a real loop branch would
+    for (s->iteration = 1; s->iteration <= s->trip; s->iteration++)
+    {
+      outcome = s->iteration < s->trip;
+      emit(s->pc, s->target, outcome, 1, 0, 0, 1);
+    }
+    lastOutcome[i] = 0;
+    return;
+  case MODEL_CORR:
+    //the partner executes first so the pair is adjacent in history
+    if (sites[s->partner].model != MODEL_CORR && s->partner != i)
+    {
+      visit(s->partner);
+    }
+    outcome = lastOutcome[s->partner] ^ s->invert;
+    emit(s->pc, s->target, outcome, 1, 0, 0, 1);
+    break;
+  case MODEL_BIAS:
+    outcome = (next_random() & 0xffff) < s->bias;
+    emit(s->pc, s->target, outcome, 1, 0, 0, 1);
+    break;
+  case MODEL_INDIRECT:
+    //skewed toward the first entries like a typical dispatch
+    outcome = 1;
+    emit(s->pc, s->table[random_below(1 + random_below(numTargets))], 1, 0, 0, 0, 0);
+    break;
+  case MODEL_CALL:
+    outcome = 1;
+    if (depth > 0 && (depth == maxDepth || random_below(2)))
+    {
+      uint32_t returnAddress = callStack[--depth];
+      emit(s->target + 0x40 + depth * 4, returnAddress, 1, 0, 0, 1, 0);
+    }
+    else
+    {
+      callStack[depth++] = s->pc + 5;
+      emit(s->pc, s->target, 1, 0, 1, 0, 1);
+    }
+    break;
+  default:
+    return;
+  }
+  lastOutcome[i] = outcome;
+}
+
+void usage()
+{
+  fprintf(stderr, "Usage: tracegen <options>\n");
+  fprintf(stderr, " Options:\n");
+  fprintf(stderr, " --records:<n>          Records to write at least (default 10000000)\n");
+  fprintf(stderr, " --static:<n>           Static branch sites (default 1024)\n");
+  fprintf(stderr, " --seed:<n>             Random seed (default 1)\n");
+  fprintf(stderr, " --mix:<l>:<c>:<b>:<i>:<r>\n");
+  fprintf(stderr, "                        Relative weights of loop, correlated, biased,\n");
+  fprintf(stderr, "                        indirect and call/ret sites (default 30:20:30:10:10)\n");
+  fprintf(stderr, " --trip:<min>:<max>     Loop trip count range (default 2:32)\n");
+  fprintf(stderr, " --targets:<n>          Indirect dispatch table size (default 8)\n");
+  fprintf(stderr, " --depth:<n>            Maximum call nesting (default 16)\n");
+  fprintf(stderr, " --binary               Write binary records instead of text\n");
+  fprintf(stderr, " --out:<file>           Output file (default stdout)\n");
+}
+
+int handle_option(char *arg)
+{
+  unsigned long long n;
+  if (!strncmp(arg, "--records:", 10) && sscanf(arg + 10, "%llu", &n) == 1)
+  {
+    numRecords = n;
+  }
+  else if (!strncmp(arg, "--static:", 9))
+  {
+    return sscanf(arg + 9, "%d", &numStatic) == 1 && numStatic > 0;
+  }
+  else if (!strncmp(arg, "--seed:", 7))
+  {
+    //xorshift never leaves zero
+    return sscanf(arg + 7, "%u", &seed) == 1 && seed != 0;
+  }
+  else if (!strncmp(arg, "--mix:", 6))
+  {
+    if (sscanf(arg + 6, "%d:%d:%d:%d:%d", &mix[0], &mix[1], &mix[2], &mix[3], &mix[4]) != NUM_MODELS)
+    {
+      return 0;
+    }
+    int total = 0;
+    for (int m = 0; m < NUM_MODELS; m++)
+    {
+      if (mix[m] < 0)
+        return 0;
+      total += mix[m];
+    }
+    return total > 0;
+  }
+  else if (!strncmp(arg, "--trip:", 7))
+  {
+    return sscanf(arg + 7, "%d:%d", &minTrip, &maxTrip) == 2 && minTrip > 0 && maxTrip >= minTrip;
+  }
+  else if (!strncmp(arg, "--targets:", 10))
+  {
+    return sscanf(arg + 10, "%d", &numTargets) == 1 && numTargets > 0;
+  }
+  else if (!strncmp(arg, "--depth:", 8))
+  {
+    return sscanf(arg + 8, "%d", &maxDepth) == 1 && maxDepth > 0;
+  }
+  else if (!strcmp(arg, "--binary"))
+  {
+    binaryOutput = 1;
+  }
+  else if (!strncmp(arg, "--out:", 6) && arg[6])
+  {
+    outPath = arg + 6;
+  }
+  else
+  {
+    return 0;
+  }
+  return 1;
+}
+
+int main(int argc, char *argv[])
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!handle_option(argv[i]))
+    {
+      printf("Unrecognized option %s\n", argv[i]);
+      usage();
+      exit(1);
+    }
+  }
+
+  outFile = stdout;
+  if (outPath && (outFile = fopen(outPath, "wb")) == NULL)
+  {
+    perror(outPath);
+    exit(1);
+  }
+  out = (char *)malloc(OUT_BLOCK);
+  outLen = 0;
+
+  init_sites();
+  if (binaryOutput)
+  {
+    memcpy(out, TRACE_MAGIC, TRACE_MAGIC_LEN);
+    outLen = TRACE_MAGIC_LEN;
+  }
+
+  //a loop visit emits its whole trip, so the last visit may overshoot
+  while (written < numRecords)
+  {
+    visit(random_below(numStatic));
+  }
+  flush_out();
+  if (outFile != stdout)
+  {
+    fclose(outFile);
+  }
+  return 0;
+}